@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <fstream>
+#include <Corrade/Utility/Arguments.h>
+#include <magnumSimpleVisualizer/magnumVisualizer.h>
+
+/*
+    Scaling benchmark of the visualizer. Builds synthetic scenes of growing
+    size through the public add*() API and measures pose sync, draw
+    submission with one and four views, world transformation updates,
+    getPos()/getRot(), picking latency through the ID buffer and by ray
+    casting, vector field updates and the cost of removing and re-adding
+    objects at each size. Results are written as one JSON object per line.
+    Build with HEADLESS_BUILD to run on display-less nodes with software GL.
+*/
+
+namespace {
+
+struct Pose {
+    float pos[3];
+    float rot[9];
+};
+
+template<class F> double medianNanoseconds(std::size_t repeat, F f) {
+    return medianNanoseconds(repeat, []{}, f);
+}
+
+/* Same, but runs setup untimed before each repetition */
+template<class S, class F> double medianNanoseconds(std::size_t repeat, S setup, F f) {
+    std::vector<double> times(repeat);
+    for(double& t: times) {
+        setup();
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        t = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::nth_element(times.begin(), times.begin() + times.size()/2, times.end());
+    return times[times.size()/2];
+}
+
+}
+
+class benchmarkApp : public Magnum::magnumVisualizer
+{
+public:
+    explicit benchmarkApp(const Arguments& arguments):
+    Magnum::magnumVisualizer(arguments, {640, 480})
+    {
+        Corrade::Utility::Arguments args;
+        args.addOption("max", "100000").setHelp("max", "largest scene, in objects")
+            .addOption("repeat", "11").setHelp("repeat", "repetitions of each measurement")
+            .addOption("output", "-").setHelp("output", "file to write JSON lines to, - for stdout")
+            .addSkippedPrefix("magnum", "engine-specific options")
+            .parse(arguments.argc, arguments.argv);
+
+        timeStateUpdates = false;
+        const std::size_t max = args.value<std::size_t>("max");
+        const std::size_t repeat = std::max<std::size_t>(1, args.value<std::size_t>("repeat"));
+        std::ofstream file;
+        if(args.value("output") != "-") file.open(args.value("output"));
+        std::ostream& out = file.is_open() ? file : std::cout;
+
+        /* Bound memory has to stay where it is, so allocate it all upfront */
+        _poses.resize(max);
+        for(std::size_t i = 0; i != max; ++i) {
+            _poses[i] = Pose{{float(i % 100)*0.05f - 2.5f, float(i/100 % 100)*0.05f - 2.5f, -float(i/10000)*0.05f},
+                {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f}};
+        }
+
+        const Magnum::ShaderCache::Stats& cache = shaderCacheStats();
+        out << "{\"shader_cache_hits\": " << cache.hits
+            << ", \"shader_cache_misses\": " << cache.misses
+            << ", \"shader_cache_saved_ns\": " << cache.savedNanoseconds
+            << "}" << std::endl;
+
+        /* Arrows along the x axis of every bound pose, empty until run() */
+        _vectorField = addVectorField(0, nullptr, sizeof(Pose), nullptr, sizeof(Pose), 0.05f);
+
+        for(std::size_t size = 1000; size <= max; size *= 10) {
+            grow(size);
+            run(size, repeat, out);
+        }
+
+        exit();
+    };
+
+private:
+    /* Grows the scene to the given object count, 1% GUI axes (at most 100,
+       each add3dAxisGUI() call is linear in object count) and the rest split
+       between bound axes and bound cylinders */
+    void grow(std::size_t size) {
+        const std::size_t count = size - _objectCount;
+        const std::size_t gui = std::min<std::size_t>(count/100, 100);
+        const std::size_t axes = (count - gui)/2;
+        const std::size_t cylinders = count - gui - axes;
+        for(std::size_t i = 0; i != gui; ++i) _handles.push_back(add3dAxisGUI(0.0f, 0.0f, -float(i)*0.01f));
+        const std::vector<Magnum::ObjectHandle> boundAxes = add3dAxisVisualizations(axes, _poses[_boundCount].pos, sizeof(Pose), _poses[_boundCount].rot, sizeof(Pose));
+        _handles.insert(_handles.end(), boundAxes.begin(), boundAxes.end());
+        _boundCount += axes;
+
+        /* The last cylinders added get respawned in run() */
+        _respawned.clear();
+        const std::vector<Magnum::ObjectHandle> boundCylinders = addCylinders(cylinders, _poses[_boundCount].pos, sizeof(Pose), _poses[_boundCount].rot, sizeof(Pose), 0.01f);
+        for(std::size_t i = 0; i != cylinders; ++i) {
+            if(cylinders - i <= 100) _respawned.push_back({_handles.size(), _boundCount + i});
+            _handles.push_back(boundCylinders[i]);
+        }
+        _boundCount += cylinders;
+        _objectCount = size;
+
+        /* Apply the initial poses */
+        updateObjectStateFromReference();
+    }
+
+    void run(std::size_t size, std::size_t repeat, std::ostream& out) {
+        const double syncChanged = medianNanoseconds(repeat, [this]{
+            for(std::size_t i = 0; i != _boundCount; ++i) _poses[i].pos[0] += 1.0e-4f;
+            updateObjectStateFromReference();
+        });
+        const double syncUnchanged = medianNanoseconds(repeat, [this]{
+            updateObjectStateFromReference();
+        });
+        const double worldTransforms = medianNanoseconds(repeat, [this]{
+            for(std::size_t i = 0; i != _boundCount; ++i) _poses[i].pos[0] += 1.0e-4f;
+            updateObjectStateFromReference();
+        }, [this]{ updateWorldTransforms(); });
+
+        setInstancedRendering(false);
+        const double draw = medianNanoseconds(repeat, [this]{ drawScene(); });
+        Magnum::GL::Renderer::finish();
+        const std::size_t stateChanges = stateChangeCount();
+        setDrawSorting(false);
+        drawScene();
+        const std::size_t stateChangesUnsorted = stateChangeCount();
+        setDrawSorting(true);
+        setInstancedRendering(true);
+        const double drawInstanced = medianNanoseconds(repeat, [this]{ drawScene(); });
+        Magnum::GL::Renderer::finish();
+        setInstancedRendering(false);
+
+        /* The same scene from four cameras in a 2x2 grid */
+        const Magnum::Vector2i half = framebufferSize()/2;
+        setViewport(0, {{}, half});
+        int views[3];
+        for(int i = 0; i != 3; ++i) {
+            const Magnum::Vector2i min{(i + 1) % 2*half.x(), (i + 1)/2*half.y()};
+            views[i] = addView({min, min + half}, viewCameraObject(0)->transformation());
+        }
+        const double drawFourViews = medianNanoseconds(repeat, [this]{ drawScene(); });
+        Magnum::GL::Renderer::finish();
+        for(int view: views) removeView(view);
+        setViewport(0, {{}, framebufferSize()});
+
+        float v[9];
+        const double getPosRot = medianNanoseconds(repeat, [this, &v]{
+            for(Magnum::ObjectHandle handle: _handles) {
+                getPos(handle, v);
+                getRot(handle, v);
+            }
+        })/double(_objectCount);
+
+        drawScene();
+        const double pickLatency = medianNanoseconds(repeat, [this]{
+            bool done = false;
+            pick(framebufferSize()/2, [&done](const std::vector<Magnum::ObjectHandle>&) { done = true; });
+            while(!done) resolvePicks();
+        });
+        RayHit hit;
+        const double rayPick = medianNanoseconds(repeat, [this, &hit]{
+            pickRay(framebufferSize()/2, hit);
+        });
+
+        /* One arrow per bound object, the same data as the poses */
+        Magnum::VectorField& field = *vectorField(_vectorField);
+        field.bind(_boundCount, _poses[0].pos, sizeof(Pose), _poses[0].rot, sizeof(Pose));
+        updateVectorFields();
+        const double vectorFieldUpdate = medianNanoseconds(repeat, [this]{
+            for(std::size_t i = 0; i != _boundCount; ++i) _poses[i].rot[0] += 1.0e-4f;
+        }, [this]{ updateVectorFields(); });
+        const double vectorFieldDraw = medianNanoseconds(repeat, [this]{ drawScene(); });
+        Magnum::GL::Renderer::finish();
+        field.bind(0, nullptr, sizeof(Pose), nullptr, sizeof(Pose));
+        updateVectorFields();
+
+        /* Remove objects and add them back bound to the same poses */
+        const double respawn = _respawned.empty() ? 0.0 : medianNanoseconds(repeat, [this]{
+            for(const std::pair<std::size_t, std::size_t>& r: _respawned) {
+                Magnum::ObjectHandle& handle = _handles[r.first];
+                remove(handle);
+                handle = addCylinder(_poses[r.second].pos, _poses[r.second].rot, 0.01f);
+            }
+        })/double(_respawned.size());
+        updateObjectStateFromReference();
+
+        out << "{\"objects\": " << size
+            << ", \"bound\": " << _boundCount
+            << ", \"sync_changed_ns\": " << syncChanged
+            << ", \"sync_unchanged_ns\": " << syncUnchanged
+            << ", \"world_transforms_ns\": " << worldTransforms
+            << ", \"draw_submit_ns\": " << draw
+            << ", \"draw_submit_instanced_ns\": " << drawInstanced
+            << ", \"draw_submit_four_views_ns\": " << drawFourViews
+            << ", \"state_changes\": " << stateChanges
+            << ", \"state_changes_unsorted\": " << stateChangesUnsorted
+            << ", \"get_pos_rot_per_object_ns\": " << getPosRot
+            << ", \"pick_latency_ns\": " << pickLatency
+            << ", \"ray_pick_ns\": " << rayPick
+            << ", \"vector_field_update_ns\": " << vectorFieldUpdate
+            << ", \"draw_submit_vector_field_ns\": " << vectorFieldDraw
+            << ", \"respawn_per_object_ns\": " << respawn
+            << "}" << std::endl;
+    }
+
+    std::vector<Pose> _poses;
+    std::vector<Magnum::ObjectHandle> _handles;
+    /* Position in _handles and pose index of objects to respawn */
+    std::vector<std::pair<std::size_t, std::size_t>> _respawned;
+    std::size_t _objectCount{}, _boundCount{};
+    int _vectorField;
+};
+
+#ifdef MAGNUM_VISUALIZER_HEADLESS
+MAGNUM_WINDOWLESSAPPLICATION_MAIN(benchmarkApp)
+#else
+MAGNUM_APPLICATION_MAIN(benchmarkApp)
+#endif
@@ -0,0 +1,326 @@
+#ifndef __DynamicAabbTree_h_
+#define __DynamicAabbTree_h_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Bounding volume hierarchy of axis-aligned boxes that is updated in place.
+
+    Every proxy stores a fattened box around the real one. move() only
+    re-inserts a proxy once its real box leaves the fat one, so objects
+    jittering around in place cost nothing, and re-insertion is O(log n) with
+    the tree kept balanced by rotations. Same scheme as the dynamic tree in
+    Box2D.
+*/
+class DynamicAabbTree {
+    public:
+        struct Aabb {
+            float min[3];
+            float max[3];
+        };
+
+        /* Insert a box fattened by margin on every side, returns the proxy */
+        int insert(const Aabb& box, int userData, float margin) {
+            const int proxy = allocateNode();
+            _nodes[proxy].box = fatten(box, margin);
+            _nodes[proxy].userData = userData;
+            _nodes[proxy].height = 0;
+            insertLeaf(proxy);
+            return proxy;
+        }
+
+        void remove(int proxy) {
+            removeLeaf(proxy);
+            freeNode(proxy);
+        }
+
+        /* Returns true if the proxy had to be re-inserted */
+        bool move(int proxy, const Aabb& box, float margin) {
+            if(contains(_nodes[proxy].box, box)) return false;
+            removeLeaf(proxy);
+            _nodes[proxy].box = fatten(box, margin);
+            insertLeaf(proxy);
+            return true;
+        }
+
+        int userData(int proxy) const { return _nodes[proxy].userData; }
+        const Aabb& fatAabb(int proxy) const { return _nodes[proxy].box; }
+        int height() const { return _root == Null ? 0 : _nodes[_root].height; }
+
+        /* Calls f(userData) for every proxy whose fat box is not completely
+           outside of the six planes. A point p is inside a plane (a, b, c, d)
+           if a*p.x + b*p.y + c*p.z + d >= 0. Subtrees completely inside all
+           planes are reported without testing their leaves. */
+        template<class F> void queryPlanes(const float (&planes)[6][4], F&& f) const {
+            if(_root == Null) return;
+            _stack.clear();
+            _stack.push_back({_root, false});
+            while(!_stack.empty()) {
+                const StackEntry e = _stack.back();
+                _stack.pop_back();
+                const Node& n = _nodes[e.node];
+
+                bool inside = e.inside;
+                if(!inside) {
+                    inside = true;
+                    bool outside = false;
+                    for(const auto& p: planes) {
+                        /* Box corners farthest along and against the normal */
+                        float far = p[3], near = p[3];
+                        for(std::size_t i = 0; i != 3; ++i) {
+                            far += p[i]*(p[i] >= 0.0f ? n.box.max[i] : n.box.min[i]);
+                            near += p[i]*(p[i] >= 0.0f ? n.box.min[i] : n.box.max[i]);
+                        }
+                        if(far < 0.0f) {
+                            outside = true;
+                            break;
+                        }
+                        if(near < 0.0f) inside = false;
+                    }
+                    if(outside) continue;
+                }
+
+                if(n.isLeaf()) f(n.userData);
+                else {
+                    _stack.push_back({n.child1, inside});
+                    _stack.push_back({n.child2, inside});
+                }
+            }
+        }
+
+        /* Calls f(userData, tmin) for every proxy whose fat box is hit by the
+           ray origin + t*direction for t in [0, maxT]. If f returns a value
+           smaller than maxT, the query continues with that as the new maxT,
+           which allows closest-hit queries to prune the rest of the tree. */
+        template<class F> void queryRay(const float (&origin)[3], const float (&direction)[3], float maxT, F&& f) const {
+            if(_root == Null) return;
+            float inverse[3];
+            for(std::size_t i = 0; i != 3; ++i)
+                inverse[i] = 1.0f/direction[i];
+            _stack.clear();
+            _stack.push_back({_root, false});
+            while(!_stack.empty()) {
+                const Node& n = _nodes[_stack.back().node];
+                _stack.pop_back();
+
+                float tmin = 0.0f, tmax = maxT;
+                bool hit = true;
+                for(std::size_t i = 0; i != 3 && hit; ++i) {
+                    float t1 = (n.box.min[i] - origin[i])*inverse[i];
+                    float t2 = (n.box.max[i] - origin[i])*inverse[i];
+                    if(t1 > t2) std::swap(t1, t2);
+                    /* Written so a NaN from 0*inf keeps the slab unbounded */
+                    tmin = t1 > tmin ? t1 : tmin;
+                    tmax = t2 < tmax ? t2 : tmax;
+                    hit = tmin <= tmax;
+                }
+                if(!hit) continue;
+
+                if(n.isLeaf()) maxT = std::min(maxT, f(n.userData, tmin));
+                else {
+                    _stack.push_back({n.child1, false});
+                    _stack.push_back({n.child2, false});
+                }
+            }
+        }
+
+    private:
+        enum: int { Null = -1 };
+
+        struct Node {
+            Aabb box;
+            int parent{Null};
+            int child1{Null}, child2{Null};
+            int height{-1};
+            int userData{};
+
+            bool isLeaf() const { return child1 == Null; }
+        };
+
+        struct StackEntry {
+            int node;
+            bool inside;
+        };
+
+        static Aabb fatten(const Aabb& box, float margin) {
+            Aabb out;
+            for(std::size_t i = 0; i != 3; ++i) {
+                out.min[i] = box.min[i] - margin;
+                out.max[i] = box.max[i] + margin;
+            }
+            return out;
+        }
+
+        static Aabb combine(const Aabb& a, const Aabb& b) {
+            Aabb out;
+            for(std::size_t i = 0; i != 3; ++i) {
+                out.min[i] = std::min(a.min[i], b.min[i]);
+                out.max[i] = std::max(a.max[i], b.max[i]);
+            }
+            return out;
+        }
+
+        static bool contains(const Aabb& outer, const Aabb& inner) {
+            for(std::size_t i = 0; i != 3; ++i)
+                if(inner.min[i] < outer.min[i] || inner.max[i] > outer.max[i]) return false;
+            return true;
+        }
+
+        /* Half the surface area, used as the insertion cost */
+        static float area(const Aabb& box) {
+            const float x = box.max[0] - box.min[0];
+            const float y = box.max[1] - box.min[1];
+            const float z = box.max[2] - box.min[2];
+            return x*y + y*z + z*x;
+        }
+
+        int allocateNode() {
+            if(_freeList == Null) {
+                _nodes.emplace_back();
+                return int(_nodes.size() - 1);
+            }
+            const int node = _freeList;
+            _freeList = _nodes[node].parent;
+            _nodes[node] = Node{};
+            return node;
+        }
+
+        void freeNode(int node) {
+            _nodes[node].parent = _freeList;
+            _nodes[node].height = -1;
+            _freeList = node;
+        }
+
+        void insertLeaf(int leaf) {
+            if(_root == Null) {
+                _root = leaf;
+                _nodes[leaf].parent = Null;
+                return;
+            }
+
+            /* Find the best sibling by the surface area heuristic */
+            const Aabb leafBox = _nodes[leaf].box;
+            int index = _root;
+            while(!_nodes[index].isLeaf()) {
+                const Node& n = _nodes[index];
+                const float nodeArea = area(n.box);
+                const float combinedArea = area(combine(n.box, leafBox));
+                const float cost = 2.0f*combinedArea;
+                const float inheritanceCost = 2.0f*(combinedArea - nodeArea);
+
+                auto childCost = [&](int child) {
+                    const float a = area(combine(leafBox, _nodes[child].box));
+                    return _nodes[child].isLeaf() ? a + inheritanceCost :
+                        a - area(_nodes[child].box) + inheritanceCost;
+                };
+                const float cost1 = childCost(n.child1);
+                const float cost2 = childCost(n.child2);
+                if(cost < cost1 && cost < cost2) break;
+                index = cost1 < cost2 ? n.child1 : n.child2;
+            }
+
+            /* Replace the sibling with a new parent of both */
+            const int sibling = index;
+            const int oldParent = _nodes[sibling].parent;
+            const int newParent = allocateNode();
+            _nodes[newParent].parent = oldParent;
+            _nodes[newParent].box = combine(leafBox, _nodes[sibling].box);
+            _nodes[newParent].height = _nodes[sibling].height + 1;
+            _nodes[newParent].child1 = sibling;
+            _nodes[newParent].child2 = leaf;
+            _nodes[sibling].parent = newParent;
+            _nodes[leaf].parent = newParent;
+            if(oldParent == Null) _root = newParent;
+            else if(_nodes[oldParent].child1 == sibling) _nodes[oldParent].child1 = newParent;
+            else _nodes[oldParent].child2 = newParent;
+
+            refitAncestors(_nodes[leaf].parent);
+        }
+
+        void removeLeaf(int leaf) {
+            if(leaf == _root) {
+                _root = Null;
+                return;
+            }
+
+            const int parent = _nodes[leaf].parent;
+            const int grandParent = _nodes[parent].parent;
+            const int sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+            if(grandParent == Null) {
+                _root = sibling;
+                _nodes[sibling].parent = Null;
+                freeNode(parent);
+                return;
+            }
+
+            if(_nodes[grandParent].child1 == parent) _nodes[grandParent].child1 = sibling;
+            else _nodes[grandParent].child2 = sibling;
+            _nodes[sibling].parent = grandParent;
+            freeNode(parent);
+            refitAncestors(grandParent);
+        }
+
+        void refitAncestors(int index) {
+            while(index != Null) {
+                index = balance(index);
+                Node& n = _nodes[index];
+                n.height = 1 + std::max(_nodes[n.child1].height, _nodes[n.child2].height);
+                n.box = combine(_nodes[n.child1].box, _nodes[n.child2].box);
+                index = n.parent;
+            }
+        }
+
+        /* Rotates the subtree at a if it's imbalanced, returns its new root */
+        int balance(int a) {
+            Node& A = _nodes[a];
+            if(A.isLeaf() || A.height < 2) return a;
+
+            const int b = A.child1, c = A.child2;
+            const int balance = _nodes[c].height - _nodes[b].height;
+            if(balance > 1) return rotate(a, c, b);
+            if(balance < -1) return rotate(a, b, c);
+            return a;
+        }
+
+        /* Promotes the taller child up over a, other is the shorter child */
+        int rotate(int a, int up, int other) {
+            Node& A = _nodes[a];
+            Node& U = _nodes[up];
+            const int f = U.child1, g = U.child2;
+
+            U.child1 = a;
+            U.parent = A.parent;
+            A.parent = up;
+            if(U.parent == Null) _root = up;
+            else if(_nodes[U.parent].child1 == a) _nodes[U.parent].child1 = up;
+            else _nodes[U.parent].child2 = up;
+
+            /* Keep the taller grandchild under up, move the other to a */
+            const bool keepF = _nodes[f].height > _nodes[g].height;
+            const int keep = keepF ? f : g, move = keepF ? g : f;
+            U.child2 = keep;
+            if(A.child1 == up) A.child1 = move;
+            else A.child2 = move;
+            _nodes[move].parent = a;
+
+            A.box = combine(_nodes[other].box, _nodes[move].box);
+            A.height = 1 + std::max(_nodes[other].height, _nodes[move].height);
+            U.box = combine(A.box, _nodes[keep].box);
+            U.height = 1 + std::max(A.height, _nodes[keep].height);
+            return up;
+        }
+
+        std::vector<Node> _nodes;
+        int _root{Null};
+        int _freeList{Null};
+        mutable std::vector<StackEntry> _stack;
+};
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef __FrameCapture_h_
+#define __FrameCapture_h_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <Corrade/Containers/Array.h>
+#include <Magnum/GL/AbstractFramebuffer.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
+#include <Magnum/GL/OpenGL.h>
+#include <Magnum/GL/PixelFormat.h>
+#include <Magnum/Math/Range.h>
+
+namespace Magnum {
+
+/*
+    Streams rendered frames as raw RGBA8 to a file or pipe.
+
+    Every captured frame is read into the next pixel buffer of a small ring
+    and only written out once its fence signals, so capturing doesn't wait on
+    the GPU unless the whole ring is still in flight. Frames are written
+    bottom-up as OpenGL stores them, e.g. for ffmpeg use
+    `-f rawvideo -pix_fmt rgba -s WxH -i - -vf vflip`.
+*/
+class FrameCapture {
+    public:
+        explicit FrameCapture(std::size_t ringSize = 3): _slots(ringSize) {}
+        ~FrameCapture() { close(); }
+
+        /* Output is a file path, "-" for stdout or "|command" to pipe into a
+           command. Captures every everyNth-th frame. */
+        bool open(const std::string& output, UnsignedInt everyNth = 1) {
+            close();
+            if(output == "-") _output = stdout;
+            else if(!output.empty() && output[0] == '|') {
+                _output = popen(output.c_str() + 1, "w");
+                _pipe = true;
+            } else _output = std::fopen(output.c_str(), "wb");
+            _decimation = everyNth ? everyNth : 1;
+            _frame = 0;
+            return _output;
+        }
+
+        /* Writes out all frames still in flight */
+        void close() {
+            if(!_output) return;
+            for(std::size_t i = 0; i != _slots.size(); ++i) {
+                Slot& slot = _slots[(_next + i) % _slots.size()];
+                if(slot.pending) flush(slot, true);
+            }
+            if(_pipe) pclose(_output);
+            else if(_output != stdout) std::fclose(_output);
+            else std::fflush(_output);
+            _output = nullptr;
+            _pipe = false;
+        }
+
+        bool isOpen() const { return _output; }
+        unsigned long long framesWritten() const { return _framesWritten; }
+
+        /* Call once per drawn frame, with the attachment to capture mapped
+           for reading */
+        void capture(GL::AbstractFramebuffer& framebuffer, const Range2Di& rectangle) {
+            if(!_output || _frame++ % _decimation) return;
+
+            /* Ring full, the oldest frame has to be written out first */
+            Slot& slot = _slots[_next];
+            if(slot.pending) flush(slot, true);
+
+            framebuffer.read(rectangle, slot.image, GL::BufferUsage::StreamRead);
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.pending = true;
+            _next = (_next + 1) % _slots.size();
+
+            /* Write out everything the GPU is done with, oldest first */
+            for(std::size_t i = 0; i != _slots.size(); ++i) {
+                Slot& s = _slots[(_next + i) % _slots.size()];
+                if(s.pending && !flush(s, false)) break;
+            }
+        }
+
+    private:
+        struct Slot {
+            GL::BufferImage2D image{GL::PixelFormat::RGBA, GL::PixelType::UnsignedByte};
+            GLsync fence{};
+            bool pending{};
+        };
+
+        bool flush(Slot& slot, bool wait) {
+            const GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+            glDeleteSync(slot.fence);
+            slot.pending = false;
+
+            const Containers::Array<char> data = slot.image.buffer().data();
+            std::fwrite(data.data(), 1, std::size_t(slot.image.size().product())*4, _output);
+            ++_framesWritten;
+            return true;
+        }
+
+        std::vector<Slot> _slots;
+        std::size_t _next{};
+        std::FILE* _output{};
+        bool _pipe{};
+        UnsignedInt _decimation{1};
+        unsigned long long _frame{}, _framesWritten{};
+};
+
+}
+
+#endif
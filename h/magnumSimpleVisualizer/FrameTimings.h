@@ -0,0 +1,172 @@
+#ifndef __FrameTimings_h_
+#define __FrameTimings_h_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Per-phase frame timings, kept in memory.
+
+    Every phase has its own fixed-size ring of the most recent samples, in
+    nanoseconds. Each phase may be recorded from a different thread (e.g.
+    stateUpdate() on the simulation thread), recording is lock-free and never
+    allocates. Statistics and CSV/JSON dumps are computed on demand from the
+    current ring contents.
+*/
+class FrameTimings {
+    public:
+        enum Phase: std::size_t {
+            StateUpdate,
+            ReferenceSync,
+            WorldTransforms,
+            Draw,
+            Blit,
+            Swap,
+            PhaseCount
+        };
+
+        static const char* phaseName(std::size_t phase) {
+            static const char* names[PhaseCount]{"stateUpdate", "referenceSync", "worldTransforms", "draw", "blit", "swap"};
+            return names[phase];
+        }
+
+        struct Stats {
+            std::size_t samples;
+            double p50, p95, p99, max;
+        };
+
+        /* Measures the time until destruction and records it to a phase */
+        class Scope {
+            public:
+                explicit Scope(FrameTimings& timings, Phase phase, bool enabled = true): _timings(enabled ? &timings : nullptr), _phase{phase} {
+                    if(_timings) _start = std::chrono::steady_clock::now();
+                }
+                ~Scope() {
+                    if(_timings) _timings->record(_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+                }
+
+            private:
+                FrameTimings* _timings;
+                Phase _phase;
+                std::chrono::steady_clock::time_point _start;
+        };
+
+        explicit FrameTimings(std::size_t capacity = 4096): _capacity{capacity} {
+            for(Ring& r: _rings)
+                r.samples.reset(new std::atomic<std::uint64_t>[capacity]());
+        }
+
+        std::size_t capacity() const { return _capacity; }
+
+        /* Only one thread may record a given phase */
+        void record(Phase phase, std::uint64_t nanoseconds) {
+            Ring& r = _rings[phase];
+            const std::uint64_t n = r.count.load(std::memory_order_relaxed);
+            r.samples[n % _capacity].store(nanoseconds, std::memory_order_relaxed);
+            r.count.store(n + 1, std::memory_order_release);
+        }
+
+        /* Total number of samples recorded, including the overwritten ones */
+        std::uint64_t count(Phase phase) const {
+            return _rings[phase].count.load(std::memory_order_acquire);
+        }
+
+        /* Samples currently in the ring, oldest first */
+        std::vector<std::uint64_t> samples(Phase phase) const {
+            const Ring& r = _rings[phase];
+            const std::uint64_t n = r.count.load(std::memory_order_acquire);
+            const std::uint64_t size = std::min<std::uint64_t>(n, _capacity);
+            std::vector<std::uint64_t> out(size);
+            for(std::uint64_t i = 0; i != size; ++i)
+                out[i] = r.samples[(n - size + i) % _capacity].load(std::memory_order_relaxed);
+            return out;
+        }
+
+        /* Rolling percentiles over the ring contents, in nanoseconds */
+        Stats stats(Phase phase) const {
+            std::vector<std::uint64_t> s = samples(phase);
+            Stats out{s.size(), 0.0, 0.0, 0.0, 0.0};
+            if(s.empty()) return out;
+            auto percentile = [&s](double p) {
+                const std::size_t i = std::min(s.size() - 1, std::size_t(p*double(s.size())));
+                std::nth_element(s.begin(), s.begin() + i, s.end());
+                return double(s[i]);
+            };
+            out.p50 = percentile(0.50);
+            out.p95 = percentile(0.95);
+            out.p99 = percentile(0.99);
+            out.max = double(*std::max_element(s.begin(), s.end()));
+            return out;
+        }
+
+        /* One row per sample, columns aligned by recency (the last row has
+           the most recent sample of every phase). Empty cells where a phase
+           has fewer samples. */
+        void writeCsv(std::ostream& out) const {
+            std::vector<std::uint64_t> s[PhaseCount];
+            std::size_t rows = 0;
+            out << "sample";
+            for(std::size_t p = 0; p != PhaseCount; ++p) {
+                s[p] = samples(Phase(p));
+                rows = std::max(rows, s[p].size());
+                out << ',' << phaseName(p) << "_ns";
+            }
+            out << '\n';
+            for(std::size_t i = 0; i != rows; ++i) {
+                out << i;
+                for(std::size_t p = 0; p != PhaseCount; ++p) {
+                    out << ',';
+                    const std::size_t offset = rows - s[p].size();
+                    if(i >= offset) out << s[p][i - offset];
+                }
+                out << '\n';
+            }
+        }
+
+        /* Statistics and raw samples of every phase */
+        void writeJson(std::ostream& out) const {
+            out << "{\n";
+            for(std::size_t p = 0; p != PhaseCount; ++p) {
+                const Stats st = stats(Phase(p));
+                out << "  \"" << phaseName(p) << "\": {\"count\": " << count(Phase(p))
+                    << ", \"p50_ns\": " << st.p50 << ", \"p95_ns\": " << st.p95
+                    << ", \"p99_ns\": " << st.p99 << ", \"max_ns\": " << st.max
+                    << ", \"samples_ns\": [";
+                const std::vector<std::uint64_t> s = samples(Phase(p));
+                for(std::size_t i = 0; i != s.size(); ++i)
+                    out << (i ? ", " : "") << s[i];
+                out << "]}" << (p + 1 != PhaseCount ? "," : "") << '\n';
+            }
+            out << "}\n";
+        }
+
+        /* One line per phase, in microseconds */
+        void writeSummary(std::ostream& out) const {
+            for(std::size_t p = 0; p != PhaseCount; ++p) {
+                const Stats st = stats(Phase(p));
+                out << phaseName(p) << ": p50 " << st.p50*1e-3 << " us, p95 "
+                    << st.p95*1e-3 << " us, p99 " << st.p99*1e-3 << " us, max "
+                    << st.max*1e-3 << " us (" << st.samples << " samples)\n";
+            }
+        }
+
+    private:
+        struct Ring {
+            std::unique_ptr<std::atomic<std::uint64_t>[]> samples;
+            std::atomic<std::uint64_t> count{0};
+        };
+
+        std::size_t _capacity;
+        Ring _rings[PhaseCount];
+};
+
+}
+
+#endif
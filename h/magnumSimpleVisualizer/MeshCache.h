@@ -0,0 +1,370 @@
+#ifndef __MeshCache_h_
+#define __MeshCache_h_
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Magnum {
+
+/*
+    Preprocessed mesh files for fast loading of large user meshes.
+
+    STL (binary or ASCII) and OBJ sources are converted once into a cache
+    file holding exactly what gets uploaded: interleaved position and normal
+    vertices and 32-bit triangle indices, plus the bounding sphere. Loading
+    a cached mesh is then one mmap() and one buffer upload per array, the
+    data is never parsed or copied on the CPU.
+
+    A cache file is named after the source path and records the source size
+    and modification time, a changed source is converted again. It also
+    records a hash of the source content, so the same mesh under different
+    paths can be shared once loaded.
+
+    All values are native-endian, like PoseLog.
+*/
+namespace MeshCache {
+    enum: std::uint32_t { Version = 1 };
+    constexpr char Magic[8]{'M', 'S', 'V', 'M', 'E', 'S', 'H', '1'};
+
+    struct Vertex {
+        float position[3];
+        float normal[3];
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t vertexStride;
+        std::uint64_t contentHash;
+        std::uint64_t sourceSize;
+        std::int64_t sourceModified;
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        float boundsCenter[3];
+        float boundsRadius;
+        /* Vertices directly follow the header, indices the vertices */
+        std::uint64_t vertexOffset;
+        std::uint64_t indexOffset;
+    };
+
+    static_assert(sizeof(Vertex) == 24 && sizeof(Header) == 80, "unexpected padding");
+
+    /* FNV-1a, stable across runs and platforms unlike std::hash */
+    inline std::uint64_t hash(const char* data, std::size_t size, std::uint64_t h = 14695981039346656037ull) {
+        for(std::size_t i = 0; i != size; ++i) h = (h ^ std::uint8_t(data[i]))*1099511628211ull;
+        return h;
+    }
+
+    /* Cache file of a source, in directory or next to the source if empty */
+    inline std::string cachePath(const std::string& source, const std::string& directory) {
+        if(directory.empty()) return source + ".msvmesh";
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash(source.data(), source.size())));
+        return directory + "/" + name + ".msvmesh";
+    }
+
+    inline void faceNormal(const float* a, const float* b, const float* c, float* n) {
+        const float u[3]{b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        const float v[3]{c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        n[0] = u[1]*v[2] - u[2]*v[1];
+        n[1] = u[2]*v[0] - u[0]*v[2];
+        n[2] = u[0]*v[1] - u[1]*v[0];
+    }
+
+    inline void normalize(float* n) {
+        const float length = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        if(length > 0.0f) for(std::size_t i = 0; i != 3; ++i) n[i] /= length;
+    }
+
+    /* Flat-shaded triangles; vertices with the same position and normal
+       (e.g. of coplanar neighbors) are merged */
+    class TriangleWelder {
+        public:
+            void add(const float (&triangle)[3][3], std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices) {
+                Vertex v{};
+                faceNormal(triangle[0], triangle[1], triangle[2], v.normal);
+                normalize(v.normal);
+                for(const float* p: triangle) {
+                    std::copy_n(p, 3, v.position);
+                    const std::string key(reinterpret_cast<const char*>(&v), sizeof(Vertex));
+                    auto found = _vertices.emplace(key, std::uint32_t(vertices.size()));
+                    if(found.second) vertices.push_back(v);
+                    indices.push_back(found.first->second);
+                }
+            }
+
+        private:
+            std::unordered_map<std::string, std::uint32_t> _vertices;
+    };
+
+    inline bool importStl(const std::string& data, std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices) {
+        TriangleWelder welder;
+        float triangle[3][3];
+
+        /* Binary, 80-byte header, triangle count and 50-byte triangles */
+        std::uint32_t count;
+        if(data.size() >= 84) {
+            std::memcpy(&count, data.data() + 80, 4);
+            if(data.size() == 84 + std::size_t(count)*50) {
+                for(std::size_t i = 0; i != count; ++i) {
+                    /* The stored normal is often garbage, recomputed instead */
+                    std::memcpy(triangle, data.data() + 84 + i*50 + 12, sizeof(triangle));
+                    welder.add(triangle, vertices, indices);
+                }
+                /* Nothing to bound or draw */
+                return count != 0;
+            }
+        }
+
+        /* ASCII, only the vertex lines matter */
+        if(data.compare(0, 5, "solid") != 0) return false;
+        std::size_t corner = 0;
+        for(const char* p = std::strstr(data.c_str(), "vertex"); p; p = std::strstr(p, "vertex")) {
+            p += 6;
+            char* end;
+            for(std::size_t i = 0; i != 3; ++i) {
+                triangle[corner][i] = std::strtof(p, &end);
+                if(end == p) return false;
+                p = end;
+            }
+            if(++corner == 3) {
+                welder.add(triangle, vertices, indices);
+                corner = 0;
+            }
+        }
+        return !indices.empty();
+    }
+
+    /* Positions, normals and polygonal faces (fan-triangulated). Faces
+       without normals get smooth normals averaged over the faces sharing a
+       position. Texture coordinates, groups and materials are ignored. */
+    inline bool importObj(const std::string& data, std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices) {
+        std::vector<float> positions, normals;
+        std::unordered_map<std::uint64_t, std::uint32_t> corners;
+        /* Vertices without a normal, and the triangles they are in */
+        std::vector<unsigned char> smooth;
+        std::vector<std::size_t> smoothTriangles;
+
+        const char* p = data.c_str();
+        const char* const end = p + data.size();
+        std::vector<std::uint32_t> face;
+        while(p < end) {
+            const char* const lineEnd = std::find(p, end, '\n');
+            char* next;
+            if(p[0] == 'v' && p[1] == ' ') {
+                for(std::size_t i = 0, q = 2; i != 3; ++i, q = 0, p = next)
+                    positions.push_back(std::strtof(p + q, &next));
+            } else if(p[0] == 'v' && p[1] == 'n' && p[2] == ' ') {
+                for(std::size_t i = 0, q = 3; i != 3; ++i, q = 0, p = next)
+                    normals.push_back(std::strtof(p + q, &next));
+            } else if(p[0] == 'f' && p[1] == ' ') {
+                face.clear();
+                bool smoothFace = false;
+                for(p += 2; p < lineEnd; ) {
+                    long v = std::strtol(p, &next, 10);
+                    if(next == p) break;
+                    long n = 0;
+                    p = next;
+                    if(*p == '/') {
+                        std::strtol(++p, &next, 10);
+                        p = next;
+                        if(*p == '/') {
+                            n = std::strtol(++p, &next, 10);
+                            p = next;
+                        }
+                    }
+                    /* 1-based, negative counts from the last one */
+                    v = v < 0 ? long(positions.size()/3) + v : v - 1;
+                    n = n < 0 ? long(normals.size()/3) + n : n - 1;
+                    if(v < 0 || std::size_t(v) >= positions.size()/3 ||
+                       (n != -1 && std::size_t(n) >= normals.size()/3)) return false;
+                    if(n == -1) smoothFace = true;
+
+                    const std::uint64_t key = std::uint64_t(v) << 32 | std::uint32_t(n);
+                    auto found = corners.emplace(key, std::uint32_t(vertices.size()));
+                    if(found.second) {
+                        Vertex vertex{};
+                        std::copy_n(positions.data() + 3*v, 3, vertex.position);
+                        if(n != -1) std::copy_n(normals.data() + 3*n, 3, vertex.normal);
+                        vertices.push_back(vertex);
+                        smooth.push_back(n == -1);
+                    }
+                    face.push_back(found.first->second);
+                    while(p < lineEnd && *p != ' ' && *p != '\t') ++p;
+                    while(p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+                }
+                for(std::size_t i = 2; i < face.size(); ++i) {
+                    if(smoothFace) smoothTriangles.push_back(indices.size());
+                    indices.insert(indices.end(), {face[0], face[i - 1], face[i]});
+                }
+            }
+            p = lineEnd + 1;
+        }
+
+        for(std::size_t first: smoothTriangles) {
+            float n[3];
+            const std::uint32_t* t = indices.data() + first;
+            faceNormal(vertices[t[0]].position, vertices[t[1]].position, vertices[t[2]].position, n);
+            /* Area-weighted, the cross product length is twice the area */
+            for(std::size_t i = 0; i != 3; ++i) if(smooth[t[i]])
+                for(std::size_t j = 0; j != 3; ++j) vertices[t[i]].normal[j] += n[j];
+        }
+        for(Vertex& v: vertices) normalize(v.normal);
+        return !indices.empty();
+    }
+}
+
+/*
+    A cached mesh, memory-mapped. load() converts the source first if there
+    is no up-to-date cache; if the cache can't be written the converted data
+    is kept in memory instead, so the mesh still loads, just slowly again
+    next time.
+*/
+class MeshFile {
+    public:
+        ~MeshFile() { close(); }
+
+        bool load(const std::string& source, const std::string& cacheDirectory) {
+            close();
+            struct stat st;
+            if(stat(source.c_str(), &st) != 0) return false;
+            const std::string cache = MeshCache::cachePath(source, cacheDirectory);
+            if(open(cache) && header().sourceSize == std::uint64_t(st.st_size) &&
+               header().sourceModified == std::int64_t(st.st_mtime))
+                return true;
+            close();
+            if(!convert(source, cache, st)) return false;
+            return !_memory.empty() || open(cache);
+        }
+
+        /* Maps a cache file, false if it's missing or not a valid cache */
+        bool open(const std::string& path) {
+            close();
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if(fd == -1) return false;
+            struct stat st;
+            if(fstat(fd, &st) == 0 && std::size_t(st.st_size) >= sizeof(MeshCache::Header)) {
+                _size = st.st_size;
+                void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+                if(data != MAP_FAILED) _data = static_cast<const char*>(data);
+            }
+            ::close(fd);
+
+            if(_data) {
+                const MeshCache::Header& h = header();
+                if(std::memcmp(h.magic, MeshCache::Magic, 8) == 0 &&
+                   h.version == MeshCache::Version &&
+                   h.vertexStride == sizeof(MeshCache::Vertex) &&
+                   h.vertexOffset == sizeof(MeshCache::Header) &&
+                   h.indexOffset == h.vertexOffset + std::uint64_t(h.vertexCount)*sizeof(MeshCache::Vertex) &&
+                   h.indexOffset + std::uint64_t(h.indexCount)*4 == _size) return true;
+            }
+            close();
+            return false;
+        }
+
+        void close() {
+            if(_data && _memory.empty()) munmap(const_cast<char*>(_data), _size);
+            _data = nullptr;
+            _size = 0;
+            _memory.clear();
+        }
+
+        const MeshCache::Header& header() const {
+            return *reinterpret_cast<const MeshCache::Header*>(_data);
+        }
+        /* The vertex and index arrays as stored, ready to be uploaded */
+        const char* vertexData() const { return _data + header().vertexOffset; }
+        std::size_t vertexDataSize() const { return std::size_t(header().vertexCount)*sizeof(MeshCache::Vertex); }
+        const char* indexData() const { return _data + header().indexOffset; }
+        std::size_t indexDataSize() const { return std::size_t(header().indexCount)*4; }
+
+    private:
+        bool convert(const std::string& source, const std::string& cache, const struct stat& st) {
+            std::ifstream in{source, std::ios::binary};
+            const std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+            if(!in && !in.eof()) return false;
+
+            std::vector<MeshCache::Vertex> vertices;
+            std::vector<std::uint32_t> indices;
+            const std::size_t dot = source.rfind('.');
+            std::string extension = dot == std::string::npos ? std::string{} : source.substr(dot + 1);
+            for(char& c: extension) c = char(std::tolower(c));
+            if(!(extension == "obj" ? MeshCache::importObj(data, vertices, indices) :
+                 extension == "stl" && MeshCache::importStl(data, vertices, indices)))
+                return false;
+
+            MeshCache::Header h{};
+            std::memcpy(h.magic, MeshCache::Magic, 8);
+            h.version = MeshCache::Version;
+            h.vertexStride = sizeof(MeshCache::Vertex);
+            h.contentHash = MeshCache::hash(data.data(), data.size());
+            h.sourceSize = st.st_size;
+            h.sourceModified = st.st_mtime;
+            h.vertexCount = std::uint32_t(vertices.size());
+            h.indexCount = std::uint32_t(indices.size());
+            h.vertexOffset = sizeof(MeshCache::Header);
+            h.indexOffset = h.vertexOffset + vertices.size()*sizeof(MeshCache::Vertex);
+
+            /* Bounding sphere around the center of the bounding box */
+            float min[3], max[3];
+            std::copy_n(vertices.front().position, 3, min);
+            std::copy_n(vertices.front().position, 3, max);
+            for(const MeshCache::Vertex& v: vertices)
+                for(std::size_t i = 0; i != 3; ++i) {
+                    min[i] = std::min(min[i], v.position[i]);
+                    max[i] = std::max(max[i], v.position[i]);
+                }
+            for(std::size_t i = 0; i != 3; ++i) h.boundsCenter[i] = (min[i] + max[i])*0.5f;
+            for(const MeshCache::Vertex& v: vertices) {
+                float d = 0.0f;
+                for(std::size_t i = 0; i != 3; ++i)
+                    d += (v.position[i] - h.boundsCenter[i])*(v.position[i] - h.boundsCenter[i]);
+                h.boundsRadius = std::max(h.boundsRadius, d);
+            }
+            h.boundsRadius = std::sqrt(h.boundsRadius);
+
+            /* Written under a temporary name and renamed, so a concurrent or
+               interrupted conversion never leaves a partial cache behind */
+            const std::string temporary = cache + ".tmp" + std::to_string(getpid());
+            if(std::FILE* f = std::fopen(temporary.c_str(), "wb")) {
+                const bool written = std::fwrite(&h, sizeof(h), 1, f) &&
+                    std::fwrite(vertices.data(), sizeof(MeshCache::Vertex), vertices.size(), f) == vertices.size() &&
+                    std::fwrite(indices.data(), 4, indices.size(), f) == indices.size();
+                if(std::fclose(f) == 0 && written && std::rename(temporary.c_str(), cache.c_str()) == 0)
+                    return true;
+                std::remove(temporary.c_str());
+            }
+
+            _memory.resize(h.indexOffset + indices.size()*4);
+            std::memcpy(&_memory[0], &h, sizeof(h));
+            std::memcpy(&_memory[h.vertexOffset], vertices.data(), vertices.size()*sizeof(MeshCache::Vertex));
+            std::memcpy(&_memory[h.indexOffset], indices.data(), indices.size()*4);
+            _data = _memory.data();
+            _size = _memory.size();
+            return true;
+        }
+
+        const char* _data{};
+        std::size_t _size{};
+        /* Converted data if the cache couldn't be written */
+        std::string _memory;
+};
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef __ObjectPool_h_
+#define __ObjectPool_h_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Reference to an object in an ObjectPool. The generation changes every
+    time a slot is freed, so a handle to a removed object stays invalid even
+    after its slot is reused. A default-constructed handle is never valid.
+*/
+struct ObjectHandle {
+    std::uint32_t index{}, generation{};
+
+    explicit operator bool() const { return generation; }
+    bool operator==(const ObjectHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const ObjectHandle& other) const { return !operator==(other); }
+    bool operator<(const ObjectHandle& other) const {
+        return index < other.index || (index == other.index && generation < other.generation);
+    }
+};
+
+/*
+    Slot allocator for objects with stable addresses.
+
+    Slots are allocated in fixed-size blocks that never move, freed slots are
+    reused first-in first-out so a slot stays unused for as long as possible
+    after a removal, which keeps stale IDs still in flight (e.g. in a pending
+    pick readback) from resolving to a new object. Live slots are also kept
+    in a dense list for iteration; destroy() moves the last entry into the
+    hole, so creation and destruction are both O(1).
+*/
+template<class T> class ObjectPool {
+    public:
+        enum: std::size_t { BlockSize = 1024 };
+
+        ObjectPool() = default;
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+        ~ObjectPool() {
+            for(std::uint32_t index: _live) slot(index)->~T();
+        }
+
+        /* Constructs T{index, args...} in a free slot */
+        template<class ...Args> ObjectHandle emplace(Args&&... args) {
+            std::uint32_t index;
+            if(!_free.empty()) {
+                index = _free.front();
+                _free.pop_front();
+            } else {
+                index = std::uint32_t(_generations.size());
+                if(index % BlockSize == 0) _blocks.emplace_back(new Storage[BlockSize]);
+                _generations.push_back(1);
+                _livePositions.push_back(NotLive);
+            }
+
+            new(slot(index)) T{index, std::forward<Args>(args)...};
+            _livePositions[index] = std::uint32_t(_live.size());
+            _live.push_back(index);
+            return {index, _generations[index]};
+        }
+
+        /* Returns false if the handle is stale */
+        bool destroy(ObjectHandle handle) {
+            if(!get(handle)) return false;
+            slot(handle.index)->~T();
+            ++_generations[handle.index];
+
+            const std::uint32_t position = _livePositions[handle.index];
+            _live[position] = _live.back();
+            _livePositions[_live[position]] = position;
+            _live.pop_back();
+            _livePositions[handle.index] = NotLive;
+            _free.push_back(handle.index);
+            return true;
+        }
+
+        /* Null if the handle is stale */
+        T* get(ObjectHandle handle) const {
+            return handle.index < _generations.size() &&
+                _generations[handle.index] == handle.generation &&
+                _livePositions[handle.index] != NotLive ? slot(handle.index) : nullptr;
+        }
+
+        /* Object in given slot, null if the slot is free or out of range */
+        T* operator[](std::size_t index) const {
+            return index < _livePositions.size() && _livePositions[index] != NotLive ? slot(index) : nullptr;
+        }
+
+        /* Handle of the object currently in given slot, invalid if free */
+        ObjectHandle handle(std::size_t index) const {
+            return (*this)[index] ? ObjectHandle{std::uint32_t(index), _generations[index]} : ObjectHandle{};
+        }
+
+        /* Indices of the live slots, in no particular order */
+        const std::vector<std::uint32_t>& live() const { return _live; }
+        std::size_t size() const { return _live.size(); }
+        /* One past the highest slot index ever used */
+        std::size_t slotCount() const { return _generations.size(); }
+
+    private:
+        enum: std::uint32_t { NotLive = ~std::uint32_t{} };
+
+        struct Storage {
+            alignas(T) unsigned char data[sizeof(T)];
+        };
+
+        T* slot(std::size_t index) const {
+            return reinterpret_cast<T*>(_blocks[index/BlockSize][index%BlockSize].data);
+        }
+
+        std::vector<std::unique_ptr<Storage[]>> _blocks;
+        std::vector<std::uint32_t> _generations, _livePositions, _live;
+        std::deque<std::uint32_t> _free;
+};
+
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef __PoseLog_h_
+#define __PoseLog_h_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Magnum {
+
+/*
+    Append-only binary log of bound poses.
+
+    The file is a 16-byte file header followed by frames, each a 16-byte
+    frame header and rowCount rows in the PoseTable snapshot layout
+    (PoseTable::SnapshotStride floats per row), so a frame can be gathered
+    straight from the file. Closing the recorder appends the frame index,
+    time and offset of every frame, followed by a footer pointing to it. A
+    log that wasn't closed (e.g. the recording process crashed) is still
+    readable, the player rebuilds the index by walking the frame headers.
+
+    All values are native-endian, logs are meant to be replayed on the
+    machine or at least the architecture they were recorded on.
+*/
+namespace PoseLog {
+    enum: std::uint32_t { Version = 1, FloatsPerRow = 12 };
+    constexpr char FileMagic[8]{'M', 'S', 'V', 'P', 'O', 'S', 'E', 'S'};
+    constexpr char IndexMagic[8]{'M', 'S', 'V', 'P', 'I', 'D', 'X', '1'};
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t floatsPerRow;
+    };
+
+    struct FrameHeader {
+        /* Seconds since the recording started */
+        double time;
+        std::uint32_t rowCount;
+        std::uint32_t padding;
+    };
+
+    struct IndexEntry {
+        double time;
+        std::uint64_t offset;
+    };
+
+    struct Footer {
+        std::uint64_t indexOffset;
+        std::uint64_t frameCount;
+        char magic[8];
+    };
+
+    static_assert(sizeof(FileHeader) == 16 && sizeof(FrameHeader) == 16 &&
+        sizeof(IndexEntry) == 16 && sizeof(Footer) == 24, "unexpected padding");
+}
+
+class PoseRecorder {
+    public:
+        ~PoseRecorder() { close(); }
+
+        bool open(const std::string& path) {
+            close();
+            _file = std::fopen(path.c_str(), "wb");
+            if(!_file) return false;
+            PoseLog::FileHeader header{{}, PoseLog::Version, PoseLog::FloatsPerRow};
+            std::memcpy(header.magic, PoseLog::FileMagic, 8);
+            _offset = std::fwrite(&header, sizeof(header), 1, _file) ? sizeof(header) : 0;
+            _index.clear();
+            return _offset;
+        }
+
+        /* Appends rowCount rows of PoseLog::FloatsPerRow floats */
+        bool write(double time, const float* rows, std::uint32_t rowCount) {
+            if(!_file) return false;
+            const PoseLog::FrameHeader header{time, rowCount, 0};
+            const std::size_t size = std::size_t(rowCount)*PoseLog::FloatsPerRow;
+            if(!std::fwrite(&header, sizeof(header), 1, _file) ||
+               std::fwrite(rows, sizeof(float), size, _file) != size) return false;
+            _index.push_back({time, _offset});
+            _offset += sizeof(header) + size*sizeof(float);
+            return true;
+        }
+
+        /* Writes the frame index */
+        void close() {
+            if(!_file) return;
+            PoseLog::Footer footer{_offset, _index.size(), {}};
+            std::memcpy(footer.magic, PoseLog::IndexMagic, 8);
+            std::fwrite(_index.data(), sizeof(PoseLog::IndexEntry), _index.size(), _file);
+            std::fwrite(&footer, sizeof(footer), 1, _file);
+            std::fclose(_file);
+            _file = nullptr;
+        }
+
+        bool isOpen() const { return _file; }
+        std::size_t frameCount() const { return _index.size(); }
+
+    private:
+        std::FILE* _file{};
+        std::uint64_t _offset{};
+        std::vector<PoseLog::IndexEntry> _index;
+};
+
+/*
+    Memory-mapped reader of a pose log. Nothing is copied, frame() points
+    into the mapping and the kernel pages frames in as they're touched, so
+    logs much larger than RAM can be replayed and seeked in.
+*/
+class PosePlayer {
+    public:
+        ~PosePlayer() { close(); }
+
+        bool open(const std::string& path) {
+            close();
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if(fd == -1) return false;
+            struct stat st;
+            if(fstat(fd, &st) == 0 && std::size_t(st.st_size) >= sizeof(PoseLog::FileHeader)) {
+                _size = st.st_size;
+                void* data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+                if(data != MAP_FAILED) _data = static_cast<const char*>(data);
+            }
+            ::close(fd);
+            if(!_data || !readIndex()) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close() {
+            if(_data) munmap(const_cast<char*>(_data), _size);
+            _data = nullptr;
+            _size = 0;
+            _index.clear();
+        }
+
+        bool isOpen() const { return _data; }
+        std::size_t frameCount() const { return _index.size(); }
+        double duration() const { return _index.empty() ? 0.0 : _index.back().time; }
+        double time(std::size_t frame) const { return _index[frame].time; }
+
+        /* Rows of a frame, in the PoseTable snapshot layout */
+        const float* frame(std::size_t frame, std::uint32_t& rowCount) const {
+            const char* header = _data + _index[frame].offset;
+            rowCount = reinterpret_cast<const PoseLog::FrameHeader*>(header)->rowCount;
+            return reinterpret_cast<const float*>(header + sizeof(PoseLog::FrameHeader));
+        }
+
+        /* Last frame recorded at or before given time, 0 if before all */
+        std::size_t frameAt(double time) const {
+            const auto found = std::upper_bound(_index.begin(), _index.end(), time,
+                [](double t, const PoseLog::IndexEntry& e) { return t < e.time; });
+            return found == _index.begin() ? 0 : found - _index.begin() - 1;
+        }
+
+    private:
+        bool readIndex() {
+            const auto* header = reinterpret_cast<const PoseLog::FileHeader*>(_data);
+            if(std::memcmp(header->magic, PoseLog::FileMagic, 8) != 0 ||
+               header->version != PoseLog::Version ||
+               header->floatsPerRow != PoseLog::FloatsPerRow) return false;
+
+            /* Index written by PoseRecorder::close() */
+            if(_size >= sizeof(PoseLog::FileHeader) + sizeof(PoseLog::Footer)) {
+                /* Copied, a truncated log can end at any alignment */
+                PoseLog::Footer footer;
+                std::memcpy(&footer, _data + _size - sizeof(PoseLog::Footer), sizeof(footer));
+                if(std::memcmp(footer.magic, PoseLog::IndexMagic, 8) == 0 &&
+                   footer.indexOffset + footer.frameCount*sizeof(PoseLog::IndexEntry) == _size - sizeof(PoseLog::Footer)) {
+                    const auto* entries = reinterpret_cast<const PoseLog::IndexEntry*>(_data + footer.indexOffset);
+                    _index.assign(entries, entries + footer.frameCount);
+                    return true;
+                }
+            }
+
+            /* Unterminated log, walk the frames and drop a truncated last one */
+            std::uint64_t offset = sizeof(PoseLog::FileHeader);
+            while(offset + sizeof(PoseLog::FrameHeader) <= _size) {
+                const auto* frame = reinterpret_cast<const PoseLog::FrameHeader*>(_data + offset);
+                const std::uint64_t next = offset + sizeof(PoseLog::FrameHeader) +
+                    std::uint64_t(frame->rowCount)*PoseLog::FloatsPerRow*sizeof(float);
+                if(next > _size) break;
+                _index.push_back({frame->time, offset});
+                offset = next;
+            }
+            return true;
+        }
+
+        const char* _data{};
+        std::size_t _size{};
+        std::vector<PoseLog::IndexEntry> _index;
+};
+
+}
+
+#endif
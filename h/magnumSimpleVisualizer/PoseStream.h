@@ -0,0 +1,423 @@
+#ifndef __PoseStream_h_
+#define __PoseStream_h_
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "TripleBuffer.h"
+
+namespace Magnum {
+
+/*
+    Pose updates streamed over a datagram socket.
+
+    Every datagram is a self-contained batch: a Header followed by count
+    records, each a 32-bit row index, the position and the rotation. The
+    rotation is either the 3x3 matrix in the PoseTable layout (right, up and
+    backward axis) or a quaternion (x, y, z, w), and all values are either
+    32-bit floats or IEEE half floats, as told by the header flags. Records
+    are packed without padding. Frames larger than a datagram are split
+    across several datagrams with the same frame number, and a frame may
+    update only some of the rows. Datagrams of a frame older than the
+    newest one received are dropped. Values are in native byte order, i.e.
+    little-endian on all platforms the visualizer runs on.
+
+    Addresses are "udp:port" or "udp:host:port" for UDP and "unix:path" for
+    a Unix-domain datagram socket.
+*/
+namespace PoseStream {
+    enum: std::uint16_t { Version = 1 };
+    enum Flag: std::uint16_t {
+        Quaternion = 1 << 0,
+        HalfFloat = 1 << 1
+    };
+    enum: std::size_t { MaxDatagramSize = 32768 };
+    constexpr char Magic[4]{'M', 'S', 'V', 'S'};
+
+    struct Header {
+        char magic[4];
+        std::uint16_t version;
+        std::uint16_t flags;
+        std::uint32_t count;
+        std::uint32_t reserved;
+        std::uint64_t frame;
+        /* Nanoseconds since the Unix epoch, for measuring latency */
+        std::uint64_t sendTime;
+    };
+
+    static_assert(sizeof(Header) == 32, "unexpected padding");
+
+    inline std::size_t recordSize(std::uint16_t flags) {
+        return 4 + (flags & Quaternion ? 7 : 12)*(flags & HalfFloat ? 2 : 4);
+    }
+
+    inline std::uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    inline float halfToFloat(std::uint16_t h) {
+        const std::uint32_t sign = std::uint32_t(h & 0x8000) << 16;
+        std::uint32_t exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff, bits;
+        if(exponent == 0x1f) bits = sign | 0x7f800000 | mantissa << 13;
+        else if(exponent) bits = sign | (exponent + 112) << 23 | mantissa << 13;
+        else if(!mantissa) bits = sign;
+        /* Denormal, normalize it */
+        else {
+            exponent = 113;
+            while(!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | exponent << 23 | (mantissa & 0x3ff) << 13;
+        }
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return f;
+    }
+
+    /* Rounds to nearest, overflows to infinity and flushes values below the
+       normal range to zero, which is plenty for poses */
+    inline std::uint16_t floatToHalf(float f) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &f, 4);
+        const std::uint16_t sign = (bits >> 16) & 0x8000;
+        const std::int32_t exponent = std::int32_t((bits >> 23) & 0xff) - 112;
+        if(((bits >> 23) & 0xff) == 0xff) return sign | 0x7c00 | ((bits & 0x7fffff) ? 0x200 : 0);
+        if(exponent <= 0) return sign;
+        const std::uint32_t rounded = (std::uint32_t(exponent) << 10 | (bits & 0x7fffff) >> 13) + ((bits >> 12) & 1);
+        return rounded >= 0x7c00 ? sign | 0x7c00 : sign | rounded;
+    }
+
+    /* Rotation matrix in the PoseTable layout from a unit quaternion */
+    inline void quaternionToMatrix(const float q[4], float m[9]) {
+        const float x = q[0], y = q[1], z = q[2], w = q[3];
+        m[0] = 1.0f - 2.0f*(y*y + z*z); m[1] = 2.0f*(x*y + z*w); m[2] = 2.0f*(x*z - y*w);
+        m[3] = 2.0f*(x*y - z*w); m[4] = 1.0f - 2.0f*(x*x + z*z); m[5] = 2.0f*(y*z + x*w);
+        m[6] = 2.0f*(x*z + y*w); m[7] = 2.0f*(y*z - x*w); m[8] = 1.0f - 2.0f*(x*x + y*y);
+    }
+
+    inline void matrixToQuaternion(const float m[9], float q[4]) {
+        /* m[3*column + row] */
+        const float m00 = m[0], m11 = m[4], m22 = m[8];
+        const float trace = m00 + m11 + m22;
+        if(trace > 0.0f) {
+            const float s = 2.0f*std::sqrt(trace + 1.0f);
+            q[0] = (m[5] - m[7])/s; q[1] = (m[6] - m[2])/s; q[2] = (m[1] - m[3])/s; q[3] = 0.25f*s;
+        } else if(m00 > m11 && m00 > m22) {
+            const float s = 2.0f*std::sqrt(1.0f + m00 - m11 - m22);
+            q[0] = 0.25f*s; q[1] = (m[3] + m[1])/s; q[2] = (m[6] + m[2])/s; q[3] = (m[5] - m[7])/s;
+        } else if(m11 > m22) {
+            const float s = 2.0f*std::sqrt(1.0f + m11 - m00 - m22);
+            q[0] = (m[3] + m[1])/s; q[1] = 0.25f*s; q[2] = (m[7] + m[5])/s; q[3] = (m[6] - m[2])/s;
+        } else {
+            const float s = 2.0f*std::sqrt(1.0f + m22 - m00 - m11);
+            q[0] = (m[6] + m[2])/s; q[1] = (m[7] + m[5])/s; q[2] = 0.25f*s; q[3] = (m[1] - m[3])/s;
+        }
+    }
+
+    /* Reads the header, returns false if the datagram is malformed */
+    inline bool readHeader(const char* data, std::size_t size, Header& header) {
+        if(size < sizeof(Header)) return false;
+        std::memcpy(&header, data, sizeof(Header));
+        return std::memcmp(header.magic, Magic, 4) == 0 && header.version == Version &&
+            size == sizeof(Header) + header.count*recordSize(header.flags);
+    }
+
+    /* Applies the records of a datagram checked by readHeader() to rows in
+       the PoseTable snapshot layout, records of rows past rowCount are
+       skipped */
+    inline void decode(const char* data, const Header& header, float* rows, std::size_t rowCount) {
+        const std::size_t record = recordSize(header.flags);
+        const bool half = header.flags & HalfFloat;
+        const std::size_t valueCount = header.flags & Quaternion ? 7 : 12;
+        const char* p = data + sizeof(Header);
+        float values[12];
+        for(std::uint32_t i = 0; i != header.count; ++i, p += record) {
+            std::uint32_t row;
+            std::memcpy(&row, p, 4);
+            if(row >= rowCount) continue;
+
+            if(half) for(std::size_t j = 0; j != valueCount; ++j) {
+                std::uint16_t h;
+                std::memcpy(&h, p + 4 + 2*j, 2);
+                values[j] = halfToFloat(h);
+            } else std::memcpy(values, p + 4, 4*valueCount);
+
+            float* out = rows + 12*row;
+            std::memcpy(out, values, 3*4);
+            if(header.flags & Quaternion) quaternionToMatrix(values + 3, out + 3);
+            else std::memcpy(out + 3, values + 3, 9*4);
+        }
+    }
+
+    /* Datagram socket bound to (receive) or connected to (send) address */
+    inline int open(const std::string& address, bool bindToAddress) {
+        if(address.compare(0, 5, "unix:") == 0) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            const std::string path = address.substr(5);
+            if(path.empty() || path.size() >= sizeof(addr.sun_path)) return -1;
+            std::memcpy(addr.sun_path, path.c_str(), path.size());
+            const int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+            if(fd == -1) return -1;
+            if(bindToAddress) unlink(path.c_str());
+            const sockaddr* a = reinterpret_cast<const sockaddr*>(&addr);
+            if((bindToAddress ? bind(fd, a, sizeof(addr)) : connect(fd, a, sizeof(addr))) != 0) {
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        if(address.compare(0, 4, "udp:") != 0) return -1;
+        const std::string hostPort = address.substr(4);
+        const std::size_t colon = hostPort.rfind(':');
+        const std::string host = colon == std::string::npos ? std::string{} : hostPort.substr(0, colon);
+        const std::string port = colon == std::string::npos ? hostPort : hostPort.substr(colon + 1);
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_flags = bindToAddress ? AI_PASSIVE : 0;
+        addrinfo* result;
+        if(getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0)
+            return -1;
+        int fd = -1;
+        for(addrinfo* a = result; a && fd == -1; a = a->ai_next) {
+            fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if(fd == -1) continue;
+            /* UDP drops whatever doesn't fit, so give bursts of datagrams
+               some room. Capped by the system limit. */
+            if(bindToAddress) {
+                const int receiveBuffer = 4 << 20;
+                setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+            }
+            if((bindToAddress ? bind(fd, a->ai_addr, a->ai_addrlen) : connect(fd, a->ai_addr, a->ai_addrlen)) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(result);
+        return fd;
+    }
+}
+
+/*
+    Sending side, for simulators and for testing the receiver over a
+    loopback address. Records are batched into datagrams of at most
+    PoseStream::MaxDatagramSize bytes.
+
+        sender.begin(frame, PoseStream::Quaternion|PoseStream::HalfFloat);
+        for(...) sender.add(row, pos, rot);
+        sender.flush();
+*/
+class PoseSender {
+    public:
+        ~PoseSender() { close(); }
+
+        bool open(const std::string& address) {
+            close();
+            _fd = PoseStream::open(address, false);
+            return _fd != -1;
+        }
+        void close() {
+            if(_fd != -1) ::close(_fd);
+            _fd = -1;
+        }
+
+        void begin(std::uint64_t frame, std::uint16_t flags = 0) {
+            _frame = frame;
+            _flags = flags;
+            startDatagram();
+        }
+
+        /* Rotation in the PoseTable layout, converted as the flags say */
+        bool add(std::uint32_t row, const float pos[3], const float rot[9]) {
+            const std::size_t record = PoseStream::recordSize(_flags);
+            if(_buffer.size() + record > PoseStream::MaxDatagramSize && !flush()) return false;
+
+            float values[12];
+            std::memcpy(values, pos, 3*4);
+            std::size_t valueCount = 12;
+            if(_flags & PoseStream::Quaternion) {
+                PoseStream::matrixToQuaternion(rot, values + 3);
+                valueCount = 7;
+            } else std::memcpy(values + 3, rot, 9*4);
+
+            const std::size_t offset = _buffer.size();
+            _buffer.resize(offset + record);
+            char* p = &_buffer[offset];
+            std::memcpy(p, &row, 4);
+            if(_flags & PoseStream::HalfFloat) for(std::size_t j = 0; j != valueCount; ++j) {
+                const std::uint16_t h = PoseStream::floatToHalf(values[j]);
+                std::memcpy(p + 4 + 2*j, &h, 2);
+            } else std::memcpy(p + 4, values, 4*valueCount);
+            ++_count;
+            return true;
+        }
+
+        /* Sends the records added since the last flush, if any */
+        bool flush() {
+            if(!_count) return true;
+            PoseStream::Header header{{}, PoseStream::Version, _flags, _count, 0, _frame, PoseStream::now()};
+            std::memcpy(header.magic, PoseStream::Magic, 4);
+            std::memcpy(&_buffer[0], &header, sizeof(header));
+            const bool sent = send(_fd, _buffer.data(), _buffer.size(), 0) == ssize_t(_buffer.size());
+            startDatagram();
+            return sent;
+        }
+
+    private:
+        void startDatagram() {
+            _buffer.assign(sizeof(PoseStream::Header), 0);
+            _count = 0;
+        }
+
+        int _fd{-1};
+        std::uint64_t _frame{};
+        std::uint16_t _flags{};
+        std::uint32_t _count{};
+        std::vector<char> _buffer;
+};
+
+/*
+    Receiving side. A background thread decodes datagrams into its own copy
+    of all rows and, once the socket is drained, publishes one snapshot of
+    them through a triple buffer. Everything that arrived in between is
+    folded into that snapshot, so under backpressure superseded frames are
+    dropped instead of queued and the render thread never waits.
+*/
+class PoseReceiver {
+    public:
+        struct Stats {
+            unsigned long long datagrams, records, dropped, published;
+            /* Snapshots skipped by update() for not matching the row count */
+            unsigned long long mismatched;
+            /* Datagrams per second over the last second */
+            double rate;
+            /* Moving average of receive time minus send time, in seconds.
+               Only meaningful if both clocks are synchronized. */
+            double latency;
+        };
+
+        ~PoseReceiver() { stop(); }
+
+        /* Rows start with the given snapshot, rows no datagram touched keep
+           these values */
+        bool start(const std::string& address, std::size_t rowCount, const float* initial) {
+            stop();
+            _fd = PoseStream::open(address, true);
+            if(_fd == -1) return false;
+            if(address.compare(0, 5, "unix:") == 0) _unixPath = address.substr(5);
+            _rows.assign(initial, initial + 12*rowCount);
+            _lastFrame = 0;
+            _datagrams = _records = _dropped = _published = 0;
+            _mismatched = 0;
+            _rate = _latency = 0.0;
+            _running = true;
+            _thread = std::thread{&PoseReceiver::loop, this};
+            return true;
+        }
+
+        void stop() {
+            if(_thread.joinable()) {
+                _running = false;
+                _thread.join();
+            }
+            if(_fd != -1) ::close(_fd);
+            _fd = -1;
+            if(!_unixPath.empty()) unlink(_unixPath.c_str());
+            _unixPath.clear();
+        }
+
+        bool isRunning() const { return _thread.joinable(); }
+
+        /* Render thread side, same as TripleBuffer. A new snapshot that
+           doesn't have rowCount rows is skipped and counted. */
+        bool update(std::size_t rowCount) {
+            if(!_snapshots.update()) return false;
+            if(_snapshots.readBuffer().size() != 12*rowCount) {
+                ++_mismatched;
+                return false;
+            }
+            return true;
+        }
+        const std::vector<float>& snapshot() const { return _snapshots.readBuffer(); }
+
+        Stats stats() const {
+            return {_datagrams, _records, _dropped, _published, _mismatched, _rate, _latency};
+        }
+
+    private:
+        void loop() {
+            std::vector<char> buffer(PoseStream::MaxDatagramSize);
+            auto windowStart = std::chrono::steady_clock::now();
+            unsigned long long windowDatagrams = 0;
+            while(_running) {
+                /* Timeout so stop() doesn't wait for a datagram */
+                pollfd p{_fd, POLLIN, 0};
+                if(poll(&p, 1, 50) <= 0) continue;
+
+                bool changed = false;
+                ssize_t size;
+                while((size = recv(_fd, buffer.data(), buffer.size(), MSG_DONTWAIT)) >= 0) {
+                    PoseStream::Header header;
+                    ++_datagrams;
+                    ++windowDatagrams;
+                    if(!PoseStream::readHeader(buffer.data(), std::size_t(size), header) || header.frame < _lastFrame) {
+                        ++_dropped;
+                        continue;
+                    }
+                    PoseStream::decode(buffer.data(), header, _rows.data(), _rows.size()/12);
+                    _lastFrame = header.frame;
+                    _records += header.count;
+                    const double latency = double(std::int64_t(PoseStream::now() - header.sendTime))*1.0e-9;
+                    _latency = _published || changed ? 0.9*_latency + 0.1*latency : latency;
+                    changed = true;
+                }
+
+                if(changed) {
+                    std::vector<float>& snapshot = _snapshots.writeBuffer();
+                    snapshot = _rows;
+                    _snapshots.publish();
+                    ++_published;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                const double window = std::chrono::duration<double>(now - windowStart).count();
+                if(window >= 1.0) {
+                    _rate = double(windowDatagrams)/window;
+                    windowDatagrams = 0;
+                    windowStart = now;
+                }
+            }
+        }
+
+        int _fd{-1};
+        std::string _unixPath;
+        std::thread _thread;
+        std::atomic<bool> _running{false};
+        /* Owned by the receiving thread */
+        std::vector<float> _rows;
+        std::uint64_t _lastFrame{};
+        TripleBuffer<std::vector<float>> _snapshots;
+        std::atomic<unsigned long long> _datagrams{}, _records{}, _dropped{}, _published{};
+        std::atomic<double> _rate{}, _latency{};
+        /* Owned by the render thread */
+        unsigned long long _mismatched{};
+};
+
+}
+
+#endif
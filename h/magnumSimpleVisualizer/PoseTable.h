@@ -0,0 +1,182 @@
+#ifndef __PoseTable_h_
+#define __PoseTable_h_
+
+#include <cstddef>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Contiguous table of poses bound to user memory.
+
+    Every row is one bound object reading its pose in place from user
+    memory. Rows are bound in bulk from a base pointer and a byte stride, so
+    an array of structs holding the position and rotation of many objects is
+    bound with a single call. Positions are 3 floats, rotations 9 floats
+    (right, up and backward axis, the same layout add3dAxisVisualization()
+    takes). A null rotation pointer means identity rotation, a null position
+    pointer the origin, e.g. for rows only ever gathered from snapshots that
+    come from elsewhere. remove() moves the last row into the removed one,
+    so rows can come and go in O(1).
+
+    gather() copies the bound values into structure-of-arrays columns and
+    computeMatrices() converts all rows to column-major 4x4 matrices in one
+    pass over these columns. gather() also records which rows differ from the
+    previous gather() (or were bound since), so only those need to be applied
+    to the scene graph.
+
+    snapshot() copies the bound memory into a packed buffer instead, which can
+    be handed over to another thread and gathered from there.
+*/
+class PoseTable {
+    public:
+        /* Floats per row in a snapshot, position followed by rotation */
+        enum: std::size_t { SnapshotStride = 12 };
+
+        /* Binds count rows, row i reads pos + i*posStride and
+           rot + i*rotStride (strides in bytes). Returns the first row. */
+        std::size_t bind(std::size_t count, const float* pos, std::ptrdiff_t posStride, const float* rot, std::ptrdiff_t rotStride) {
+            const std::size_t first = _size;
+            const char* p = reinterpret_cast<const char*>(pos);
+            const char* q = reinterpret_cast<const char*>(rot);
+            for(std::size_t i = 0; i != count; ++i) {
+                _rows.push_back({pos ? reinterpret_cast<const float*>(p + std::ptrdiff_t(i)*posStride) : Origin,
+                    rot ? reinterpret_cast<const float*>(q + std::ptrdiff_t(i)*rotStride) : Identity});
+            }
+            _size += count;
+            for(auto& c: _pos) c.resize(_size);
+            for(auto& c: _rot) c.resize(_size);
+            _fresh.resize(_size, 1);
+            return first;
+        }
+
+        std::size_t size() const { return _size; }
+
+        /* Unbinds a row by moving the last row into its place. Returns the
+           previous index of the moved row, which is row itself if it was
+           the last one. Invalidates changedRows(). */
+        std::size_t remove(std::size_t row) {
+            const std::size_t last = _size - 1;
+            _rows[row] = _rows[last];
+            for(auto& c: _pos) c[row] = c[last];
+            for(auto& c: _rot) c[row] = c[last];
+            _fresh[row] = _fresh[last];
+
+            _rows.pop_back();
+            for(auto& c: _pos) c.pop_back();
+            for(auto& c: _rot) c.pop_back();
+            _fresh.pop_back();
+            _changed.clear();
+            --_size;
+            return last;
+        }
+
+        /* Copy the current values of the bound user memory into the table.
+           Returns the number of rows that changed, see changedRows(). */
+        std::size_t gather() {
+            _changed.clear();
+            for(std::size_t row = 0; row != _size; ++row)
+                gatherRow(row, _rows[row].pos, _rows[row].rot);
+            return _changed.size();
+        }
+
+        /* Same as gather(), but reads a packed buffer filled by snapshot()
+           instead of the bound user memory */
+        std::size_t gather(const float* snapshot) {
+            _changed.clear();
+            for(std::size_t row = 0; row != _size; ++row) {
+                const float* p = snapshot + SnapshotStride*row;
+                gatherRow(row, p, p + 3);
+            }
+            return _changed.size();
+        }
+
+        /* Copy the bound user memory into SnapshotStride floats per row.
+           Doesn't modify the table, so it can run on the thread that writes
+           the bound memory while another thread gathers. */
+        void snapshot(float* out) const {
+            for(std::size_t i = 0; i != _size; ++i) {
+                float* row = out + SnapshotStride*i;
+                const float* p = _rows[i].pos;
+                const float* q = _rows[i].rot;
+                for(std::size_t j = 0; j != 3; ++j) row[j] = p[j];
+                for(std::size_t j = 0; j != 9; ++j) row[3 + j] = q[j];
+            }
+        }
+
+        /* Same layout as snapshot(), but with the values of the last
+           gather() instead of the bound memory */
+        void gathered(float* out) const {
+            for(std::size_t i = 0; i != _size; ++i) {
+                float* row = out + SnapshotStride*i;
+                for(std::size_t j = 0; j != 3; ++j) row[j] = _pos[j][i];
+                for(std::size_t j = 0; j != 9; ++j) row[3 + j] = _rot[j][i];
+            }
+        }
+
+        /* Rows changed by the last gather(), in ascending order */
+        const std::vector<std::size_t>& changedRows() const { return _changed; }
+
+        /* Drops the changes of the last gather() without applying them, they
+           are reported by the next gather() again even if the values then
+           don't differ. For gathers from a buffer that turned out to be
+           inconsistent. */
+        void discardChanges() {
+            for(std::size_t row: _changed) _fresh[row] = 1;
+            _changed.clear();
+        }
+
+        /* Write 16 floats per row, column-major, rotation axes in the first
+           three columns and position in the last one */
+        void computeMatrices(float* matrices) const {
+            const float* __restrict px = _pos[0].data();
+            const float* __restrict py = _pos[1].data();
+            const float* __restrict pz = _pos[2].data();
+            float* __restrict m = matrices;
+            for(std::size_t i = 0; i != _size; ++i) {
+                float* __restrict row = m + 16*i;
+                row[0] = _rot[0][i]; row[1] = _rot[1][i]; row[2] = _rot[2][i]; row[3] = 0.0f;
+                row[4] = _rot[3][i]; row[5] = _rot[4][i]; row[6] = _rot[5][i]; row[7] = 0.0f;
+                row[8] = _rot[6][i]; row[9] = _rot[7][i]; row[10] = _rot[8][i]; row[11] = 0.0f;
+                row[12] = px[i]; row[13] = py[i]; row[14] = pz[i]; row[15] = 1.0f;
+            }
+        }
+
+        /* Structure-of-arrays columns filled by gather() */
+        const std::vector<float>& position(std::size_t component) const { return _pos[component]; }
+        const std::vector<float>& rotation(std::size_t component) const { return _rot[component]; }
+
+    private:
+        static constexpr float Origin[3]{0.0f, 0.0f, 0.0f};
+        static constexpr float Identity[9]{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+
+        struct Row {
+            const float* pos;
+            const float* rot;
+        };
+
+        void gatherRow(std::size_t row, const float* p, const float* q) {
+            bool changed = _fresh[row];
+            for(std::size_t j = 0; j != 3; ++j) {
+                changed |= _pos[j][row] != p[j];
+                _pos[j][row] = p[j];
+            }
+            for(std::size_t j = 0; j != 9; ++j) {
+                changed |= _rot[j][row] != q[j];
+                _rot[j][row] = q[j];
+            }
+            if(changed) _changed.push_back(row);
+            _fresh[row] = 0;
+        }
+
+        std::vector<Row> _rows;
+        std::vector<float> _pos[3];
+        std::vector<float> _rot[9];
+        std::vector<unsigned char> _fresh;
+        std::vector<std::size_t> _changed;
+        std::size_t _size{};
+};
+
+}
+
+#endif
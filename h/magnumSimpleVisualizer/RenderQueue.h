@@ -0,0 +1,78 @@
+#ifndef __RenderQueue_h_
+#define __RenderQueue_h_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Draw order of one frame.
+
+    Every item carries a 64-bit key compared as an unsigned integer, so the
+    most significant field sorts first: shader, then mesh, then depth front
+    to back so early depth testing rejects as many hidden fragments as
+    possible. Sorting is a stable LSD radix sort over the key bytes, linear
+    in the item count. Bytes that are equal in all keys, such as the unused
+    low bits or the shader in a single-shader scene, cost nothing but the
+    histogram pass.
+*/
+class RenderQueue {
+    public:
+        struct Item {
+            std::uint64_t key;
+            std::uint32_t index;
+        };
+
+        /* Depth is the distance along the view direction, negative depths
+           sort as zero */
+        static std::uint64_t key(std::uint8_t shader, std::uint16_t mesh, float depth) {
+            /* Non-negative floats order the same as their bit patterns, the
+               top 24 bits keep the exponent and 15 bits of mantissa */
+            if(!(depth > 0.0f)) depth = 0.0f;
+            std::uint32_t bits;
+            std::memcpy(&bits, &depth, 4);
+            return std::uint64_t(shader) << 56 | std::uint64_t(mesh) << 40 | std::uint64_t(bits >> 8) << 16;
+        }
+
+        void clear() { _items.clear(); }
+        void push(std::uint64_t key, std::uint32_t index) { _items.push_back({key, index}); }
+
+        void sort() {
+            const std::size_t n = _items.size();
+            if(n < 2) return;
+
+            /* Histograms of all eight bytes in one pass */
+            std::size_t counts[8][256]{};
+            for(const Item& item: _items)
+                for(std::size_t b = 0; b != 8; ++b)
+                    ++counts[b][(item.key >> 8*b) & 0xff];
+
+            _scratch.resize(n);
+            for(std::size_t b = 0; b != 8; ++b) {
+                std::size_t* count = counts[b];
+                if(count[(_items.front().key >> 8*b) & 0xff] == n) continue;
+
+                std::size_t offset = 0;
+                for(std::size_t i = 0; i != 256; ++i) {
+                    const std::size_t c = count[i];
+                    count[i] = offset;
+                    offset += c;
+                }
+                for(const Item& item: _items)
+                    _scratch[count[(item.key >> 8*b) & 0xff]++] = item;
+                _items.swap(_scratch);
+            }
+        }
+
+        std::size_t size() const { return _items.size(); }
+        const std::vector<Item>& items() const { return _items; }
+
+    private:
+        std::vector<Item> _items, _scratch;
+};
+
+}
+
+#endif
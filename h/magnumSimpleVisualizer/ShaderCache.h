@@ -0,0 +1,196 @@
+#ifndef __ShaderCache_h_
+#define __ShaderCache_h_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <Corrade/Utility/Directory.h>
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/OpenGL.h>
+
+namespace Magnum {
+
+/*
+    On-disk cache of linked shader program binaries.
+
+    Entries are keyed by a hash of the shader sources and the GL vendor,
+    renderer and version strings, so a driver update or a changed shader
+    simply misses. A program is loaded with glProgramBinary() on a hit; on a
+    miss, or if the driver rejects the stored binary, the caller compiles and
+    links as usual and stores the result. The cache directory is
+    $MAGNUM_VISUALIZER_SHADER_CACHE, $XDG_CACHE_HOME/magnumSimpleVisualizer or
+    ~/.cache/magnumSimpleVisualizer; setting the variable to 0 disables it.
+    Files are written to a temporary name and renamed, so concurrently
+    starting processes never see partial entries.
+
+    Usage in a shader constructor:
+
+        const std::string key = ShaderCache::key({vertSource, fragSource});
+        if(!ShaderCache::global().load(*this, key)) {
+            const auto start = ShaderCache::Clock::now();
+            ... compile and attach shaders ...
+            ShaderCache::prepare(*this);
+            CORRADE_INTERNAL_ASSERT(link());
+            ShaderCache::global().store(*this, key, start);
+        }
+*/
+class ShaderCache {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Stats {
+            std::size_t hits, misses;
+            /* Stored compile time of the hits minus the time to load them */
+            double savedNanoseconds;
+        };
+
+        static ShaderCache& global() {
+            static ShaderCache cache;
+            return cache;
+        }
+
+        /* Hash of the sources, GLSL version and the current driver */
+        static std::string key(std::initializer_list<std::string> sources, GL::Version version = GL::Version::GL430) {
+            std::uint64_t hash = 14695981039346656037ull;
+            auto add = [&hash](const std::string& s) {
+                for(unsigned char c: s) {
+                    hash ^= c;
+                    hash *= 1099511628211ull;
+                }
+                /* Separator so "ab"+"c" and "a"+"bc" differ */
+                hash ^= 0xff;
+                hash *= 1099511628211ull;
+            };
+            for(const std::string& s: sources) add(s);
+            GL::Context& context = GL::Context::current();
+            add(std::to_string(Int(version)));
+            add(context.vendorString());
+            add(context.rendererString());
+            add(context.versionString());
+
+            char out[17];
+            std::snprintf(out, sizeof(out), "%016llx", static_cast<unsigned long long>(hash));
+            return out;
+        }
+
+        /* Call before link() so the driver keeps the binary retrievable */
+        static void prepare(GL::AbstractShaderProgram& program) {
+            glProgramParameteri(program.id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        /* Returns true if the program was linked from the cache */
+        bool load(GL::AbstractShaderProgram& program, const std::string& key) {
+            if(!enabled()) return false;
+            const Clock::time_point start = Clock::now();
+
+            std::ifstream in{path(key), std::ios::binary|std::ios::ate};
+            const std::uint64_t fileSize = in ? std::uint64_t(in.tellg()) : 0;
+            in.seekg(0);
+            Header header;
+            std::vector<char> data;
+            /* A truncated or corrupt file is a miss, its size field isn't
+               trusted for the allocation */
+            if(in && in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+               std::string(header.magic, 4) == "MSVB" &&
+               header.size == fileSize - sizeof(header)) {
+                data.resize(header.size);
+                in.read(data.data(), data.size());
+            }
+            if(!in || data.empty()) {
+                ++_stats.misses;
+                return false;
+            }
+
+            glProgramBinary(program.id(), header.format, data.data(), GLsizei(data.size()));
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program.id(), GL_LINK_STATUS, &linked);
+            if(!linked) {
+                ++_stats.misses;
+                return false;
+            }
+
+            ++_stats.hits;
+            _stats.savedNanoseconds += header.compileNanoseconds -
+                std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            return true;
+        }
+
+        /* Stores a program linked after prepare(), start is when compiling
+           began */
+        void store(GL::AbstractShaderProgram& program, const std::string& key, Clock::time_point start) {
+            if(!enabled()) return;
+            Header header;
+            header.compileNanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+            GLint length = 0;
+            glGetProgramiv(program.id(), GL_PROGRAM_BINARY_LENGTH, &length);
+            if(length <= 0) return;
+            std::vector<char> data(length);
+            GLenum format;
+            glGetProgramBinary(program.id(), length, nullptr, &format, data.data());
+            header.format = format;
+            header.size = data.size();
+
+            Utility::Directory::mkpath(_directory);
+            const std::string target = path(key);
+            const std::string temporary = target + ".tmp" + std::to_string(getpid());
+            {
+                std::ofstream out{temporary, std::ios::binary};
+                out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                out.write(data.data(), data.size());
+                if(!out) {
+                    std::remove(temporary.c_str());
+                    return;
+                }
+            }
+            std::rename(temporary.c_str(), target.c_str());
+        }
+
+        const Stats& stats() const { return _stats; }
+        const std::string& directory() const { return _directory; }
+
+    private:
+        struct Header {
+            char magic[4]{'M', 'S', 'V', 'B'};
+            std::uint32_t format{};
+            std::uint64_t size{};
+            double compileNanoseconds{};
+        };
+
+        ShaderCache() {
+            const char* dir = std::getenv("MAGNUM_VISUALIZER_SHADER_CACHE");
+            const char* xdg = std::getenv("XDG_CACHE_HOME");
+            if(dir) _directory = std::string{dir} == "0" ? "" : dir;
+            else if(xdg && *xdg) _directory = Utility::Directory::join(xdg, "magnumSimpleVisualizer");
+            else _directory = Utility::Directory::join(Utility::Directory::home(), ".cache/magnumSimpleVisualizer");
+        }
+
+        /* Needs a current context, so checked on first use */
+        bool enabled() {
+            if(_supported < 0) {
+                GLint formats = 0;
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+                _supported = formats > 0;
+            }
+            return _supported && !_directory.empty();
+        }
+
+        std::string path(const std::string& key) const {
+            return Utility::Directory::join(_directory, key + ".bin");
+        }
+
+        std::string _directory;
+        int _supported{-1};
+        Stats _stats{};
+};
+
+}
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef __SharedPoses_h_
+#define __SharedPoses_h_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Magnum {
+
+/*
+    Poses published by another process through POSIX shared memory.
+
+    The region starts with a Header describing the layout, followed by two
+    slots of capacity rows each, rows in the PoseTable snapshot layout. The
+    writer fills the slot not holding the latest frame and then publishes it,
+    so a reader is only ever raced if the writer publishes twice while it
+    reads. Each slot is guarded by a seqlock: the sequence is odd while the
+    slot is written, a reader remembers the sequence before reading and the
+    frame is torn if it differs afterwards.
+
+    Both sides map the region once, reading and publishing a frame involves
+    no syscalls. The writer (typically the simulator) uses SharedPoseWriter,
+    which only depends on this header.
+*/
+namespace SharedPoseRegion {
+    enum: std::uint32_t { Version = 1, FloatsPerRow = 12 };
+    constexpr char Magic[8]{'M', 'S', 'V', 'S', 'H', 'M', 'P', 'S'};
+
+    struct alignas(64) Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t floatsPerRow;
+        /* Rows per slot */
+        std::uint32_t capacity;
+        std::uint32_t padding;
+        /* Number of the latest complete frame, its slot is latest % 2. 0
+           means nothing was published yet. */
+        std::atomic<std::uint64_t> latest;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> sequence;
+        std::uint64_t frame;
+        /* Seconds on the writer clock, for the user */
+        double time;
+        std::uint32_t rowCount;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+        "the seqlock needs address-free atomics");
+
+    /* Rounded up so the second slot stays aligned */
+    inline std::size_t slotSize(std::uint32_t capacity) {
+        return (sizeof(Slot) + std::size_t(capacity)*FloatsPerRow*sizeof(float) + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+    }
+    inline std::size_t size(std::uint32_t capacity) {
+        return sizeof(Header) + 2*slotSize(capacity);
+    }
+
+    /* Maps an existing region, or creates it if capacity is nonzero */
+    inline void* map(const std::string& name, std::uint32_t capacity, std::size_t& size) {
+        const int fd = capacity ? shm_open(name.c_str(), O_RDWR|O_CREAT, 0600) :
+            shm_open(name.c_str(), O_RDONLY, 0);
+        if(fd == -1) return nullptr;
+        struct stat st;
+        if(capacity) {
+            size = SharedPoseRegion::size(capacity);
+            if(ftruncate(fd, size) != 0) size = 0;
+        } else size = fstat(fd, &st) == 0 ? st.st_size : 0;
+
+        void* data = size >= sizeof(Header) ? mmap(nullptr, size,
+            capacity ? PROT_READ|PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        return data == MAP_FAILED ? nullptr : data;
+    }
+}
+
+class SharedPoseWriter {
+    public:
+        ~SharedPoseWriter() { close(); }
+
+        /* Creates the region or reinitializes an existing one. Readers
+           attached to a previous region of the same name have to reattach. */
+        bool create(const std::string& name, std::uint32_t capacity) {
+            close();
+            _data = static_cast<char*>(SharedPoseRegion::map(name, capacity, _size));
+            if(!_data) return false;
+
+            auto& header = *new(_data) SharedPoseRegion::Header{};
+            header.version = SharedPoseRegion::Version;
+            header.floatsPerRow = SharedPoseRegion::FloatsPerRow;
+            header.capacity = capacity;
+            for(std::size_t i = 0; i != 2; ++i) new(slot(i)) SharedPoseRegion::Slot{};
+            /* Magic last, a reader checking it sees a complete header */
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(header.magic, SharedPoseRegion::Magic, 8);
+            _capacity = capacity;
+            _frame = 0;
+            return true;
+        }
+
+        void close() {
+            if(_data) munmap(_data, _size);
+            _data = nullptr;
+        }
+
+        std::uint32_t capacity() const { return _capacity; }
+
+        /* Rows to fill for the next frame, then call publish() */
+        float* rows() {
+            SharedPoseRegion::Slot& s = *slot((_frame + 1) % 2);
+            s.sequence.store(s.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            return reinterpret_cast<float*>(&s + 1);
+        }
+
+        void publish(std::uint32_t rowCount, double time = 0.0) {
+            SharedPoseRegion::Slot& s = *slot((_frame + 1) % 2);
+            s.frame = ++_frame;
+            s.time = time;
+            s.rowCount = rowCount;
+            s.sequence.store(s.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            reinterpret_cast<SharedPoseRegion::Header*>(_data)->latest.store(_frame, std::memory_order_release);
+        }
+
+    private:
+        SharedPoseRegion::Slot* slot(std::size_t i) {
+            return reinterpret_cast<SharedPoseRegion::Slot*>(_data + sizeof(SharedPoseRegion::Header) + i*SharedPoseRegion::slotSize(_capacity));
+        }
+
+        char* _data{};
+        std::size_t _size{};
+        std::uint32_t _capacity{};
+        std::uint64_t _frame{};
+};
+
+/*
+    Reader side. acquire() returns the rows of the latest frame in place,
+    the caller consumes them and then asks validate() whether the writer
+    touched the slot in the meantime.
+*/
+class SharedPoseReader {
+    public:
+        enum class Result {
+            /* A new frame, call validate() after reading it */
+            Frame,
+            /* Nothing published since the last frame */
+            Stale,
+            /* The writer is just filling the latest slot, try again later */
+            Busy
+        };
+
+        ~SharedPoseReader() { close(); }
+
+        bool open(const std::string& name) {
+            close();
+            _data = static_cast<const char*>(SharedPoseRegion::map(name, 0, _size));
+            if(!_data) return false;
+            const auto& h = header();
+            if(std::memcmp(h.magic, SharedPoseRegion::Magic, 8) != 0 ||
+               h.version != SharedPoseRegion::Version ||
+               h.floatsPerRow != SharedPoseRegion::FloatsPerRow ||
+               _size < SharedPoseRegion::size(h.capacity)) {
+                close();
+                return false;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            _lastFrame = 0;
+            return true;
+        }
+
+        void close() {
+            if(_data) munmap(const_cast<char*>(_data), _size);
+            _data = nullptr;
+        }
+
+        bool isOpen() const { return _data; }
+        std::uint32_t capacity() const { return header().capacity; }
+
+        Result acquire(const float*& rows, std::uint32_t& rowCount) {
+            const std::uint64_t frame = header().latest.load(std::memory_order_acquire);
+            if(frame == _lastFrame) return Result::Stale;
+
+            _slot = slot(frame % 2);
+            _sequence = _slot->sequence.load(std::memory_order_acquire);
+            /* Odd while written, a different frame if the writer already
+               lapped it */
+            if(_sequence % 2 || _slot->frame != frame) return Result::Busy;
+
+            rowCount = std::min(_slot->rowCount, header().capacity);
+            rows = reinterpret_cast<const float*>(_slot + 1);
+            _time = _slot->time;
+            _pendingFrame = frame;
+            return Result::Frame;
+        }
+
+        /* True if the rows returned by the last acquire() weren't written
+           while being read. A torn frame is retried on the next acquire(). */
+        bool validate() {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(_slot->sequence.load(std::memory_order_relaxed) != _sequence) return false;
+            _lastFrame = _pendingFrame;
+            return true;
+        }
+
+        /* Frame number and writer time of the last valid frame */
+        std::uint64_t frame() const { return _lastFrame; }
+        double time() const { return _time; }
+
+    private:
+        const SharedPoseRegion::Header& header() const {
+            return *reinterpret_cast<const SharedPoseRegion::Header*>(_data);
+        }
+        const SharedPoseRegion::Slot* slot(std::size_t i) const {
+            return reinterpret_cast<const SharedPoseRegion::Slot*>(_data + sizeof(SharedPoseRegion::Header) + i*SharedPoseRegion::slotSize(header().capacity));
+        }
+
+        const char* _data{};
+        std::size_t _size{};
+        const SharedPoseRegion::Slot* _slot{};
+        std::uint64_t _sequence{}, _lastFrame{}, _pendingFrame{};
+        double _time{};
+};
+
+}
+
+#endif
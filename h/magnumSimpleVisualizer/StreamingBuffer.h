@@ -0,0 +1,127 @@
+#ifndef __StreamingBuffer_h_
+#define __StreamingBuffer_h_
+
+#include <algorithm>
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/OpenGL.h>
+
+namespace Magnum {
+
+/*
+    Shader storage buffer of T that is rewritten every frame.
+
+    The buffer is split into three regions used round-robin, so the CPU fills
+    one while the GPU may still read the previous two; a fence per region
+    makes map() wait only if the GPU falls three frames behind. Mapping more
+    than once a frame (e.g. once per view) needs setMapsPerFrame(), which
+    gives every frame that many regions. With
+    ARB_buffer_storage the buffer is persistently and coherently mapped and
+    written in place, otherwise a region is filled in a staging array and
+    uploaded with a single setSubData().
+
+        T* data = buffer.map(count);
+        ... write count elements ...
+        buffer.unmap(count);
+        buffer.bind(binding);
+        ... draws indexing the buffer starting at buffer.offset() ...
+        buffer.fence();
+*/
+template<class T> class StreamingBuffer {
+    public:
+        enum: std::size_t { FramesInFlight = 3 };
+
+        explicit StreamingBuffer(): _buffer{NoCreate}, _persistent{GL::Context::current().isExtensionSupported<GL::Extensions::ARB::buffer_storage>()}, _fences(FramesInFlight) {}
+        ~StreamingBuffer() {
+            for(GLsync fence: _fences) if(fence) glDeleteSync(fence);
+        }
+
+        StreamingBuffer(const StreamingBuffer&) = delete;
+        StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+        /* Memory for count elements in the next region */
+        T* map(std::size_t count) {
+            if(count > _capacity) reserve(count);
+            _region = (_region + 1) % _fences.size();
+            wait(_region);
+            return _persistent ? _mapped + _region*_capacity : _staging.data();
+        }
+
+        /* Call once the first count elements of the region are written */
+        void unmap(std::size_t count) {
+            if(!_persistent && count)
+                _buffer.setSubData(_region*_capacity*sizeof(T), Containers::arrayView(_staging.data(), count));
+        }
+
+        /* Index of the first element of the current region in the buffer */
+        UnsignedInt offset() const { return UnsignedInt(_region*_capacity); }
+
+        void bind(UnsignedInt index) {
+            if(_capacity) _buffer.bind(GL::Buffer::Target::ShaderStorage, index);
+        }
+
+        /* Call after submitting all draws that read the current region */
+        void fence() {
+            if(_capacity) _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        /* Recreates the buffer if the count differs */
+        void setMapsPerFrame(std::size_t count) {
+            if(FramesInFlight*count == _fences.size()) return;
+            for(std::size_t i = 0; i != _fences.size(); ++i) wait(i);
+            _fences.assign(FramesInFlight*count, {});
+            _region = 0;
+            if(_capacity) allocate();
+        }
+        std::size_t mapsPerFrame() const { return _fences.size()/FramesInFlight; }
+
+        bool isPersistent() const { return _persistent; }
+        std::size_t capacity() const { return _capacity; }
+
+    private:
+        void wait(std::size_t region) {
+            GLsync& fence = _fences[region];
+            if(!fence) return;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            glDeleteSync(fence);
+            fence = {};
+        }
+
+        /* Immutable storage can't be resized, so the buffer is recreated
+           once nothing reads it anymore */
+        void reserve(std::size_t count) {
+            for(std::size_t i = 0; i != _fences.size(); ++i) wait(i);
+            _capacity = std::max({count, 2*_capacity, std::size_t{256}});
+            allocate();
+        }
+
+        void allocate() {
+            const std::size_t size = _fences.size()*_capacity*sizeof(T);
+
+            _buffer = GL::Buffer{GL::Buffer::TargetHint::ShaderStorage};
+            if(_persistent) {
+                _buffer.setStorage({nullptr, size}, GL::Buffer::StorageFlag::MapWrite|
+                    GL::Buffer::StorageFlag::MapPersistent|GL::Buffer::StorageFlag::MapCoherent);
+                _mapped = reinterpret_cast<T*>(_buffer.map(0, size, GL::Buffer::MapFlag::Write|
+                    GL::Buffer::MapFlag::Persistent|GL::Buffer::MapFlag::Coherent).data());
+            } else {
+                _buffer.setData({nullptr, size}, GL::BufferUsage::StreamDraw);
+                _staging.resize(_capacity);
+            }
+        }
+
+        GL::Buffer _buffer;
+        bool _persistent;
+        T* _mapped{};
+        std::vector<T> _staging;
+        std::size_t _capacity{}, _region{};
+        /* One per region */
+        std::vector<GLsync> _fences;
+};
+
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef __ThreadPool_h_
+#define __ThreadPool_h_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Fixed set of worker threads running parallel loops.
+
+    parallelFor() cuts the index range into chunks and deals them out in
+    contiguous runs, one run to the queue of each thread, so every thread
+    starts on neighboring data. A thread takes chunks from the front of its
+    own queue and once that is empty steals from the back of the others, so
+    uneven chunks don't leave threads idle while one is still busy. The
+    calling thread works on its own queue too and returns once all chunks
+    are done.
+
+    Workers spin for a short while after a loop before going to sleep, as
+    loops issued back to back (e.g. one per hierarchy level) would otherwise
+    pay for a wake-up each.
+*/
+class ThreadPool {
+    public:
+        /* Total thread count including the calling one, 0 means one per
+           hardware thread */
+        explicit ThreadPool(std::size_t threadCount = 0) {
+            if(!threadCount) threadCount = std::max(1u, std::thread::hardware_concurrency());
+            for(std::size_t i = 0; i != threadCount; ++i)
+                _queues.emplace_back(new Queue);
+            for(std::size_t i = 1; i != threadCount; ++i)
+                _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _stopping = true;
+            }
+            _wake.notify_all();
+            for(std::thread& t: _workers) t.join();
+        }
+
+        std::size_t threadCount() const { return _queues.size(); }
+
+        /* Calls f(begin, end) for chunks of at most grain indices covering
+           [0, count), concurrently from all threads. Not reentrant, only one
+           thread may issue loops. */
+        template<class F> void parallelFor(std::size_t count, std::size_t grain, F&& f) {
+            grain = std::max<std::size_t>(grain, 1);
+            if(_workers.empty() || count <= grain) {
+                if(count) f(std::size_t{}, count);
+                return;
+            }
+
+            _function = [](void* context, std::size_t begin, std::size_t end) {
+                (*static_cast<typename std::remove_reference<F>::type*>(context))(begin, end);
+            };
+            _context = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+
+            const std::size_t chunks = (count + grain - 1)/grain;
+            const std::size_t perQueue = (chunks + _queues.size() - 1)/_queues.size();
+            _pending.store(chunks, std::memory_order_relaxed);
+            for(std::size_t q = 0; q != _queues.size(); ++q) {
+                std::lock_guard<std::mutex> lock{_queues[q]->mutex};
+                for(std::size_t c = q*perQueue; c < std::min((q + 1)*perQueue, chunks); ++c)
+                    _queues[q]->chunks.emplace_back(c*grain, std::min((c + 1)*grain, count));
+            }
+            {
+                std::lock_guard<std::mutex> lock{_mutex};
+                _generation.fetch_add(1, std::memory_order_release);
+            }
+            _wake.notify_all();
+
+            while(runChunk(0)) {}
+            /* Whatever is left is being run by the workers */
+            while(_pending.load(std::memory_order_acquire)) std::this_thread::yield();
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::pair<std::size_t, std::size_t>> chunks;
+        };
+
+        /* Runs a chunk from the own queue or a stolen one, false if there
+           was nothing left anywhere */
+        bool runChunk(std::size_t self) {
+            std::pair<std::size_t, std::size_t> chunk;
+            bool found = false;
+            for(std::size_t i = 0; i != _queues.size() && !found; ++i) {
+                Queue& q = *_queues[(self + i) % _queues.size()];
+                std::lock_guard<std::mutex> lock{q.mutex};
+                if(q.chunks.empty()) continue;
+                if(i == 0) {
+                    chunk = q.chunks.front();
+                    q.chunks.pop_front();
+                } else {
+                    chunk = q.chunks.back();
+                    q.chunks.pop_back();
+                }
+                found = true;
+            }
+            if(!found) return false;
+
+            /* The queue lock ordered this after the loop setup */
+            _function(_context, chunk.first, chunk.second);
+            _pending.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+
+        void workerLoop(std::size_t self) {
+            std::size_t seen = 0;
+            for(;;) {
+                while(runChunk(self)) {}
+
+                /* Spin a bit for the next loop before sleeping */
+                bool woken = false;
+                for(std::size_t i = 0; i != SpinCount && !woken; ++i) {
+                    std::this_thread::yield();
+                    woken = _generation.load(std::memory_order_acquire) != seen;
+                }
+                if(woken) {
+                    seen = _generation.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock{_mutex};
+                _wake.wait(lock, [&]{ return _stopping || _generation.load(std::memory_order_relaxed) != seen; });
+                if(_stopping) return;
+                seen = _generation.load(std::memory_order_relaxed);
+            }
+        }
+
+        enum: std::size_t { SpinCount = 2000 };
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::vector<std::thread> _workers;
+        void(*_function)(void*, std::size_t, std::size_t){};
+        void* _context{};
+        std::atomic<std::size_t> _pending{};
+
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::atomic<std::size_t> _generation{};
+        bool _stopping{};
+};
+
+}
+
+#endif
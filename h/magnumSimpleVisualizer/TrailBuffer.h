@@ -0,0 +1,144 @@
+#ifndef __TrailBuffer_h_
+#define __TrailBuffer_h_
+
+#include <algorithm>
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Vector4.h>
+
+namespace Magnum {
+
+/* Per-trail data, std430 layout matching Trail.vert */
+struct TrailData {
+    Color3 color;
+    /* Index of the first sample of the trail, NoSample if unused */
+    UnsignedInt firstSample;
+    /* Written to the ID buffer, so clicking a trail picks its object */
+    UnsignedInt objectId;
+    UnsignedInt padding[3];
+};
+
+static_assert(sizeof(TrailData) == 32, "TrailData doesn't match the std430 layout");
+
+/*
+    Position history of many objects in one GPU ring buffer.
+
+    Every append() adds one sample to all trails at once. The ring is laid
+    out sample-major, row k % length() holds sample k of every trail slot, so
+    an append uploads exactly one contiguous row with a single setSubData(),
+    no matter how long the trails are. All trails are drawn from the buffers
+    with a single attribute-less GL_LINES draw, the vertex shader fetching
+    the segment ends by gl_VertexID and dropping segments older than the
+    trail or the recorded history.
+
+    Slots of removed trails are reused, firstSample keeps their old history
+    from showing up. Growing past the slot capacity copies the ring into a
+    wider buffer on the GPU, changing the length discards all history.
+*/
+class TrailBuffer {
+    public:
+        enum: UnsignedInt {
+            SampleBinding = 2,
+            TrailBinding = 3,
+            NoSample = ~UnsignedInt{}
+        };
+
+        explicit TrailBuffer(UnsignedInt length = 256): _length{std::max(length, 2u)} {}
+
+        /* Returns the slot of the new trail */
+        UnsignedInt add(const Color3& color, UnsignedInt objectId) {
+            UnsignedInt slot;
+            if(!_free.empty()) {
+                slot = _free.back();
+                _free.pop_back();
+            } else {
+                slot = UnsignedInt(_trails.size());
+                if(slot == _capacity) reserve(std::max(2*_capacity, 64u));
+                _trails.emplace_back();
+                _row.emplace_back();
+            }
+
+            _trails[slot] = TrailData{color, _sampleCount, objectId, {}};
+            _trailBuffer.setSubData(slot*sizeof(TrailData), Containers::arrayView(&_trails[slot], 1));
+            ++_size;
+            return slot;
+        }
+
+        void remove(UnsignedInt slot) {
+            _trails[slot].firstSample = NoSample;
+            _trailBuffer.setSubData(slot*sizeof(TrailData), Containers::arrayView(&_trails[slot], 1));
+            _free.push_back(slot);
+            --_size;
+        }
+
+        /* Position of a trail for the next append(), slots that aren't set
+           repeat their previous position */
+        void setSample(UnsignedInt slot, const Vector3& position) {
+            _row[slot] = Vector4{position, 0.0f};
+        }
+
+        /* Uploads the positions as the newest sample of all trails */
+        void append() {
+            if(_trails.empty()) return;
+            _sampleBuffer.setSubData((_sampleCount % _length)*_capacity*sizeof(Vector4),
+                Containers::arrayView(_row.data(), _row.size()));
+            ++_sampleCount;
+        }
+
+        /* Discards all samples */
+        void setLength(UnsignedInt length) {
+            _length = std::max(length, 2u);
+            if(!_capacity) return;
+            _sampleBuffer.setData({nullptr, _length*_capacity*sizeof(Vector4)}, GL::BufferUsage::DynamicDraw);
+            for(TrailData& trail: _trails)
+                if(trail.firstSample != NoSample) trail.firstSample = _sampleCount;
+            _trailBuffer.setSubData(0, Containers::arrayView(_trails.data(), _trails.size()));
+        }
+
+        UnsignedInt length() const { return _length; }
+        /* Samples appended so far, the newest one has index sampleCount() - 1 */
+        UnsignedInt sampleCount() const { return _sampleCount; }
+        /* Row stride of the ring, in samples */
+        UnsignedInt capacity() const { return _capacity; }
+        /* Live trails */
+        std::size_t size() const { return _size; }
+        /* Two per segment, for all slots including unused ones */
+        UnsignedInt vertexCount() const { return UnsignedInt(_trails.size())*2*(_length - 1); }
+
+        void bind() {
+            _sampleBuffer.bind(GL::Buffer::Target::ShaderStorage, SampleBinding);
+            _trailBuffer.bind(GL::Buffer::Target::ShaderStorage, TrailBinding);
+        }
+
+    private:
+        void reserve(UnsignedInt capacity) {
+            GL::Buffer samples{GL::Buffer::TargetHint::ShaderStorage};
+            samples.setData({nullptr, _length*capacity*sizeof(Vector4)}, GL::BufferUsage::DynamicDraw);
+            for(UnsignedInt row = 0; _capacity && row != _length; ++row)
+                GL::Buffer::copy(_sampleBuffer, samples, row*_capacity*sizeof(Vector4),
+                    row*capacity*sizeof(Vector4), _capacity*sizeof(Vector4));
+            _sampleBuffer = std::move(samples);
+
+            GL::Buffer trails{GL::Buffer::TargetHint::ShaderStorage};
+            trails.setData({nullptr, capacity*sizeof(TrailData)}, GL::BufferUsage::DynamicDraw);
+            if(_capacity)
+                GL::Buffer::copy(_trailBuffer, trails, 0, 0, _capacity*sizeof(TrailData));
+            _trailBuffer = std::move(trails);
+
+            _capacity = capacity;
+        }
+
+        GL::Buffer _sampleBuffer{NoCreate}, _trailBuffer{NoCreate};
+        UnsignedInt _length, _capacity{}, _sampleCount{};
+        std::size_t _size{};
+        std::vector<TrailData> _trails;
+        std::vector<Vector4> _row;
+        std::vector<UnsignedInt> _free;
+};
+
+}
+
+#endif
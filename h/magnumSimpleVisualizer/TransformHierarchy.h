@@ -0,0 +1,219 @@
+#ifndef __TransformHierarchy_h_
+#define __TransformHierarchy_h_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "ThreadPool.h"
+
+namespace Magnum {
+
+/*
+    World transformations of a node hierarchy, computed in parallel.
+
+    Nodes are identified by a caller-chosen key (the visualizer uses the
+    object slot) and stored flattened in level order: all roots first, then
+    all their children, and so on, every node knowing the position of its
+    parent. A node's parent is thus always in an earlier level, so update()
+    computes one level at a time with the matrix products of a level spread
+    over a ThreadPool, each level only reading the one before.
+
+    setLocal() marks a node dirty. update() recomputes the dirty nodes and
+    everything below them and nothing else, updated() then lists the keys
+    whose world transformation changed. Structural changes (add(), remove(),
+    setParent()) only mark the order stale, it's rebuilt in a single pass on
+    the next update(), so adding or removing many nodes stays linear.
+
+    Matrices are 16 floats, column-major.
+*/
+class TransformHierarchy {
+    public:
+        enum: int { NoParent = -1 };
+
+        /* Adds a node with identity local transformation */
+        void add(std::size_t key, int parent = NoParent) {
+            if(key >= _parentKeys.size()) {
+                _parentKeys.resize(key + 1, Absent);
+                _positions.resize(key + 1);
+            }
+            _parentKeys[key] = parent;
+            _positions[key] = _keys.size();
+            _keys.push_back(key);
+            _parents.push_back(NoParent);
+            _local.insert(_local.end(), Identity, Identity + 16);
+            _world.insert(_world.end(), Identity, Identity + 16);
+            _dirty.push_back(1);
+            _changed.push_back(0);
+            _orderStale = true;
+        }
+
+        /* Children of a removed node become roots on the next update(),
+           unless the key is added again before */
+        void remove(std::size_t key) {
+            _parentKeys[key] = Absent;
+            _orderStale = true;
+        }
+
+        bool contains(std::size_t key) const {
+            return key < _parentKeys.size() && _parentKeys[key] != Absent;
+        }
+
+        /* Returns false if parent is the node itself or one of its
+           descendants */
+        bool setParent(std::size_t key, int parent) {
+            for(int p = parent; p != NoParent; p = _parentKeys[p])
+                if(std::size_t(p) == key) return false;
+            _parentKeys[key] = parent;
+            _dirty[_positions[key]] = 1;
+            _orderStale = true;
+            return true;
+        }
+        int parent(std::size_t key) const { return _parentKeys[key]; }
+
+        void setLocal(std::size_t key, const float* matrix) {
+            const std::size_t i = _positions[key];
+            std::copy(matrix, matrix + 16, _local.data() + 16*i);
+            _dirty[i] = 1;
+        }
+
+        /* Valid after update() */
+        const float* world(std::size_t key) const {
+            return _world.data() + 16*_positions[key];
+        }
+
+        /* Recomputes the world transformation of all dirty nodes and their
+           descendants. Levels of at most grain nodes are done on the calling
+           thread alone. */
+        void update(ThreadPool* pool = nullptr, std::size_t grain = 1024) {
+            if(_orderStale) rebuild();
+            _updated.clear();
+
+            for(std::size_t level = 0; level + 1 < _levels.size(); ++level) {
+                const std::size_t first = _levels[level];
+                auto compute = [this, first](std::size_t begin, std::size_t end) {
+                    for(std::size_t i = first + begin; i != first + end; ++i) {
+                        const int p = _parents[i];
+                        _changed[i] = _dirty[i] || (p != NoParent && _changed[p]);
+                        if(!_changed[i]) continue;
+                        if(p == NoParent)
+                            std::copy_n(_local.data() + 16*i, 16, _world.data() + 16*i);
+                        else multiply(_world.data() + 16*p, _local.data() + 16*i, _world.data() + 16*i);
+                        _dirty[i] = 0;
+                    }
+                };
+                const std::size_t count = _levels[level + 1] - first;
+                if(pool) pool->parallelFor(count, grain, compute);
+                else compute(0, count);
+            }
+
+            for(std::size_t i = 0; i != _keys.size(); ++i)
+                if(_changed[i]) _updated.push_back(_keys[i]);
+        }
+
+        /* Keys recomputed by the last update(), parents before children */
+        const std::vector<std::size_t>& updated() const { return _updated; }
+
+        std::size_t size() const { return _keys.size(); }
+        std::size_t levelCount() const { return _levels.empty() ? 0 : _levels.size() - 1; }
+
+    private:
+        enum: int { Absent = -2 };
+        static constexpr float Identity[16]{
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f};
+
+        /* out = a*b, column-major */
+        static void multiply(const float* __restrict a, const float* __restrict b, float* __restrict out) {
+            for(std::size_t col = 0; col != 4; ++col)
+                for(std::size_t row = 0; row != 4; ++row)
+                    out[4*col + row] = a[row]*b[4*col] + a[4 + row]*b[4*col + 1] +
+                        a[8 + row]*b[4*col + 2] + a[12 + row]*b[4*col + 3];
+        }
+
+        /* Drops removed nodes and sorts the rest by depth, keeping their
+           relative order within a level */
+        void rebuild() {
+            std::vector<int> depths(_parentKeys.size(), -1);
+            std::vector<std::size_t> chain;
+            std::size_t levelCount = 0;
+            /* A key removed and added again is in the list twice, only the
+               last entry is live */
+            auto live = [this](std::size_t i) {
+                return _parentKeys[_keys[i]] != Absent && _positions[_keys[i]] == i;
+            };
+            for(std::size_t i = 0; i != _keys.size(); ++i) {
+                const std::size_t key = _keys[i];
+                if(!live(i) || depths[key] != -1) continue;
+                /* Walk up to the first node of known depth */
+                std::size_t k = key;
+                for(;;) {
+                    chain.push_back(k);
+                    int& p = _parentKeys[k];
+                    if(p != NoParent && _parentKeys[p] == Absent) {
+                        p = NoParent;
+                        _dirty[_positions[k]] = 1;
+                    }
+                    if(p == NoParent || depths[p] != -1) break;
+                    k = p;
+                }
+                int depth = _parentKeys[chain.back()] == NoParent ? -1 : depths[_parentKeys[chain.back()]];
+                for(auto c = chain.rbegin(); c != chain.rend(); ++c) depths[*c] = ++depth;
+                levelCount = std::max(levelCount, std::size_t(depth) + 1);
+                chain.clear();
+            }
+
+            _levels.assign(levelCount + 1, 0);
+            for(std::size_t i = 0; i != _keys.size(); ++i)
+                if(live(i)) ++_levels[depths[_keys[i]] + 1];
+            for(std::size_t l = 0; l != levelCount; ++l) _levels[l + 1] += _levels[l];
+
+            std::vector<std::size_t> keys(_levels.back());
+            std::vector<std::size_t> next(_levels.begin(), _levels.end() - 1);
+            for(std::size_t i = 0; i != _keys.size(); ++i)
+                if(live(i)) keys[next[depths[_keys[i]]]++] = _keys[i];
+
+            std::vector<int> parents(keys.size());
+            std::vector<float> local(16*keys.size()), world(16*keys.size());
+            std::vector<unsigned char> dirty(keys.size());
+            for(std::size_t i = 0; i != keys.size(); ++i) {
+                const std::size_t old = _positions[keys[i]];
+                std::copy_n(_local.data() + 16*old, 16, local.data() + 16*i);
+                std::copy_n(_world.data() + 16*old, 16, world.data() + 16*i);
+                dirty[i] = _dirty[old];
+            }
+            for(std::size_t i = 0; i != keys.size(); ++i) _positions[keys[i]] = i;
+            for(std::size_t i = 0; i != keys.size(); ++i) {
+                const int p = _parentKeys[keys[i]];
+                parents[i] = p == NoParent ? NoParent : int(_positions[p]);
+            }
+
+            _keys = std::move(keys);
+            _parents = std::move(parents);
+            _local = std::move(local);
+            _world = std::move(world);
+            _dirty = std::move(dirty);
+            _changed.assign(_keys.size(), 0);
+            _orderStale = false;
+        }
+
+        /* Indexed by key */
+        std::vector<int> _parentKeys;
+        std::vector<std::size_t> _positions;
+
+        /* Indexed by position, in level order once rebuilt */
+        std::vector<std::size_t> _keys;
+        std::vector<int> _parents;
+        std::vector<float> _local, _world;
+        std::vector<unsigned char> _dirty, _changed;
+        /* First position of each level, and the node count at the end */
+        std::vector<std::size_t> _levels;
+
+        std::vector<std::size_t> _updated;
+        bool _orderStale{};
+};
+
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef __TriangleBvh_h_
+#define __TriangleBvh_h_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace Magnum {
+
+/*
+    Static bounding volume hierarchy over the triangles of one mesh, for
+    exact ray queries on the CPU.
+
+    Built once by splitting at the centroid median along the longest axis
+    of each node, so even meshes with millions of triangles are only a few
+    dozen levels deep and a ray touches a handful of leaves. Triangles are
+    copied into the leaf order, nine floats each, so a leaf is one
+    contiguous read. Nodes are stored depth-first, the first child right
+    after its parent.
+*/
+class TriangleBvh {
+    public:
+        enum: std::size_t { LeafSize = 4 };
+
+        /* Vertex positions are three floats at positionStride bytes apart,
+           indices three per triangle */
+        void build(const void* positions, std::size_t positionStride, const std::uint32_t* indices, std::size_t triangleCount) {
+            _triangles.resize(9*triangleCount);
+            for(std::size_t i = 0; i != triangleCount; ++i)
+                for(std::size_t j = 0; j != 3; ++j)
+                    std::memcpy(_triangles.data() + 9*i + 3*j,
+                        static_cast<const char*>(positions) + indices[3*i + j]*positionStride, 3*sizeof(float));
+
+            std::vector<std::uint32_t> order(triangleCount);
+            std::iota(order.begin(), order.end(), 0);
+            _nodes.clear();
+            if(triangleCount) buildNode(order, 0, triangleCount);
+
+            /* Reorder the triangles to the leaves */
+            std::vector<float> sorted(_triangles.size());
+            for(std::size_t i = 0; i != triangleCount; ++i)
+                std::copy_n(_triangles.data() + 9*order[i], 9, sorted.data() + 9*i);
+            _triangles = std::move(sorted);
+        }
+
+        std::size_t triangleCount() const { return _triangles.size()/9; }
+
+        /* Closest triangle hit by origin + t*direction for t in [0, maxT],
+           both sides count. Returns false if there's none, otherwise t. */
+        bool raycast(const float (&origin)[3], const float (&direction)[3], float maxT, float& t) const {
+            if(_nodes.empty()) return false;
+            float inverse[3];
+            for(std::size_t i = 0; i != 3; ++i) inverse[i] = 1.0f/direction[i];
+
+            bool found = false;
+            std::uint32_t stack[64];
+            std::size_t size = 0;
+            stack[size++] = 0;
+            while(size) {
+                const Node& n = _nodes[stack[--size]];
+                if(!hitsBox(n, origin, inverse, maxT)) continue;
+
+                if(n.count) {
+                    for(std::uint32_t i = n.first; i != n.first + n.count; ++i) {
+                        float hit;
+                        if(hitsTriangle(_triangles.data() + 9*i, origin, direction, hit) && hit <= maxT) {
+                            maxT = hit;
+                            found = true;
+                        }
+                    }
+                } else {
+                    /* Depth is bounded by the median split, no overflow */
+                    stack[size++] = n.first;
+                    stack[size++] = std::uint32_t(&n - _nodes.data()) + 1;
+                }
+            }
+            if(found) t = maxT;
+            return found;
+        }
+
+    private:
+        struct Node {
+            float min[3], max[3];
+            /* Triangles of a leaf, or the second child if count is 0 */
+            std::uint32_t first, count;
+        };
+
+        std::size_t buildNode(std::vector<std::uint32_t>& order, std::size_t begin, std::size_t end) {
+            const std::size_t index = _nodes.size();
+            _nodes.emplace_back();
+            Node n;
+            float centroidMin[3], centroidMax[3];
+            for(std::size_t i = 0; i != 3; ++i) {
+                n.min[i] = centroidMin[i] = 3.4e38f;
+                n.max[i] = centroidMax[i] = -3.4e38f;
+            }
+            for(std::size_t k = begin; k != end; ++k) {
+                const float* t = _triangles.data() + 9*order[k];
+                for(std::size_t i = 0; i != 3; ++i) {
+                    const float c = (t[i] + t[3 + i] + t[6 + i])/3.0f;
+                    centroidMin[i] = std::min(centroidMin[i], c);
+                    centroidMax[i] = std::max(centroidMax[i], c);
+                    for(std::size_t j = 0; j != 3; ++j) {
+                        n.min[i] = std::min(n.min[i], t[3*j + i]);
+                        n.max[i] = std::max(n.max[i], t[3*j + i]);
+                    }
+                }
+            }
+
+            if(end - begin <= LeafSize) {
+                n.first = std::uint32_t(begin);
+                n.count = std::uint32_t(end - begin);
+                _nodes[index] = n;
+                return index;
+            }
+
+            std::size_t axis = 0;
+            for(std::size_t i = 1; i != 3; ++i)
+                if(centroidMax[i] - centroidMin[i] > centroidMax[axis] - centroidMin[axis]) axis = i;
+            const std::size_t middle = begin + (end - begin)/2;
+            std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                [this, axis](std::uint32_t a, std::uint32_t b) {
+                    const float* ta = _triangles.data() + 9*a;
+                    const float* tb = _triangles.data() + 9*b;
+                    return ta[axis] + ta[3 + axis] + ta[6 + axis] < tb[axis] + tb[3 + axis] + tb[6 + axis];
+                });
+
+            buildNode(order, begin, middle);
+            n.first = std::uint32_t(buildNode(order, middle, end));
+            n.count = 0;
+            _nodes[index] = n;
+            return index;
+        }
+
+        static bool hitsBox(const Node& n, const float (&origin)[3], const float (&inverse)[3], float maxT) {
+            float tmin = 0.0f, tmax = maxT;
+            for(std::size_t i = 0; i != 3; ++i) {
+                float t1 = (n.min[i] - origin[i])*inverse[i];
+                float t2 = (n.max[i] - origin[i])*inverse[i];
+                if(t1 > t2) std::swap(t1, t2);
+                /* Same NaN handling as DynamicAabbTree::queryRay() */
+                tmin = t1 > tmin ? t1 : tmin;
+                tmax = t2 < tmax ? t2 : tmax;
+                if(tmin > tmax) return false;
+            }
+            return true;
+        }
+
+        /* Moeller-Trumbore */
+        static bool hitsTriangle(const float* v, const float (&origin)[3], const float (&direction)[3], float& t) {
+            const float e1[3]{v[3] - v[0], v[4] - v[1], v[5] - v[2]};
+            const float e2[3]{v[6] - v[0], v[7] - v[1], v[8] - v[2]};
+            const float p[3]{direction[1]*e2[2] - direction[2]*e2[1],
+                             direction[2]*e2[0] - direction[0]*e2[2],
+                             direction[0]*e2[1] - direction[1]*e2[0]};
+            const float det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+            if(det == 0.0f) return false;
+            const float inverseDet = 1.0f/det;
+            const float s[3]{origin[0] - v[0], origin[1] - v[1], origin[2] - v[2]};
+            const float u = (s[0]*p[0] + s[1]*p[1] + s[2]*p[2])*inverseDet;
+            if(u < 0.0f || u > 1.0f) return false;
+            const float q[3]{s[1]*e1[2] - s[2]*e1[1],
+                             s[2]*e1[0] - s[0]*e1[2],
+                             s[0]*e1[1] - s[1]*e1[0]};
+            const float w = (direction[0]*q[0] + direction[1]*q[1] + direction[2]*q[2])*inverseDet;
+            if(w < 0.0f || u + w > 1.0f) return false;
+            t = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2])*inverseDet;
+            return t >= 0.0f;
+        }
+
+        std::vector<Node> _nodes;
+        std::vector<float> _triangles;
+};
+
+}
+
+#endif
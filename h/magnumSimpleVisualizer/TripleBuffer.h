@@ -0,0 +1,44 @@
+#ifndef __TripleBuffer_h_
+#define __TripleBuffer_h_
+
+#include <atomic>
+
+namespace Magnum {
+
+/*
+    Lock-free single producer, single consumer triple buffer.
+
+    The producer fills writeBuffer() and calls publish(), the consumer calls
+    update() and reads readBuffer(). Each side always owns one of the three
+    buffers exclusively, the third one is swapped through an atomic index, so
+    neither side ever waits and the consumer always sees the latest complete
+    buffer.
+*/
+template<class T> class TripleBuffer {
+    public:
+        /* Producer side */
+        T& writeBuffer() { return _buffers[_write]; }
+        void publish() {
+            _write = _middle.exchange(_write|FreshBit, std::memory_order_acq_rel) & IndexMask;
+        }
+
+        /* Consumer side. Returns true if a buffer was published since the
+           last call, readBuffer() then refers to it. */
+        bool update() {
+            if(!(_middle.load(std::memory_order_relaxed) & FreshBit)) return false;
+            _read = _middle.exchange(_read, std::memory_order_acq_rel) & IndexMask;
+            return true;
+        }
+        const T& readBuffer() const { return _buffers[_read]; }
+
+    private:
+        enum: unsigned { IndexMask = 3, FreshBit = 4 };
+
+        T _buffers[3];
+        unsigned _write{0}, _read{1};
+        std::atomic<unsigned> _middle{2};
+};
+
+}
+
+#endif
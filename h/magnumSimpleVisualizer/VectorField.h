@@ -0,0 +1,134 @@
+#ifndef __VectorField_h_
+#define __VectorField_h_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Color.h>
+
+namespace Magnum {
+
+/*
+    Arrows read in place from user memory, e.g. contact forces or
+    velocities, drawn all at once.
+
+    Like PoseTable, the field is bound to strided arrays of origins and
+    vectors (3 floats each, strides in bytes), so an array of per-contact
+    structs is bound directly. update() copies them into a packed array of
+    FloatsPerArrow floats per arrow and uploads that only if anything
+    differs from the previous update. The arrow geometry isn't stored
+    anywhere, Arrow.vert generates it from gl_VertexID for every instance,
+    so the draw is a single attribute-less instanced call with one instance
+    per arrow and the per-frame cost is one buffer upload of 24 bytes per
+    arrow.
+*/
+class VectorField {
+    public:
+        enum: std::size_t {
+            FloatsPerArrow = 6,
+            /* Triangles around the shaft and head, see Arrow.vert */
+            Sides = 8,
+            VertexCount = 12*Sides
+        };
+        enum: UnsignedInt { Binding = 4 };
+
+        explicit VectorField(std::size_t count, const float* origins, std::ptrdiff_t originStride, const float* vectors, std::ptrdiff_t vectorStride) {
+            bind(count, origins, originStride, vectors, vectorStride);
+        }
+
+        /* Rebinds the field, e.g. when the number of contacts changed */
+        void bind(std::size_t count, const float* origins, std::ptrdiff_t originStride, const float* vectors, std::ptrdiff_t vectorStride) {
+            _count = count;
+            _origins = reinterpret_cast<const char*>(origins);
+            _vectors = reinterpret_cast<const char*>(vectors);
+            _originStride = originStride;
+            _vectorStride = vectorStride;
+            /* Forces an upload on the next update() */
+            _arrows.clear();
+        }
+
+        std::size_t size() const { return _count; }
+
+        /* Copies the bound arrays into FloatsPerArrow floats per arrow */
+        void snapshot(float* out) const {
+            for(std::size_t i = 0; i != _count; ++i) {
+                const float* o = reinterpret_cast<const float*>(_origins + std::ptrdiff_t(i)*_originStride);
+                const float* v = reinterpret_cast<const float*>(_vectors + std::ptrdiff_t(i)*_vectorStride);
+                std::copy_n(o, 3, out + FloatsPerArrow*i);
+                std::copy_n(v, 3, out + FloatsPerArrow*i + 3);
+            }
+        }
+
+        /* Reads the bound arrays, returns true if anything changed,
+           including the style */
+        bool update() {
+            _scratch.resize(_count*FloatsPerArrow);
+            snapshot(_scratch.data());
+            return update(_scratch.data());
+        }
+
+        /* Same, but from data filled by snapshot(), e.g. on another thread */
+        bool update(const float* arrows) {
+            const std::size_t size = _count*FloatsPerArrow;
+            const bool styleChanged = _styleChanged;
+            _styleChanged = false;
+            if(_arrows.size() == size && std::equal(arrows, arrows + size, _arrows.begin()))
+                return styleChanged;
+            _arrows.assign(arrows, arrows + size);
+            /* Orphaned, a draw still reading the previous data doesn't stall */
+            _buffer.setData(Containers::arrayView(_arrows.data(), _arrows.size()), GL::BufferUsage::StreamDraw);
+            return true;
+        }
+
+        /* Arrow length is the vector length times scale */
+        VectorField& setScale(Float scale) {
+            _scale = scale;
+            _styleChanged = true;
+            return *this;
+        }
+        Float scale() const { return _scale; }
+        /* Shaft radius, the head is twice as wide */
+        VectorField& setRadius(Float radius) {
+            _radius = radius;
+            _styleChanged = true;
+            return *this;
+        }
+        Float radius() const { return _radius; }
+        VectorField& setColor(const Color3& color) {
+            _color = color;
+            _styleChanged = true;
+            return *this;
+        }
+        const Color3& color() const { return _color; }
+        /* Colors arrows by vector length from min (blue) to max (red)
+           instead of the fixed color, max <= min turns it off */
+        VectorField& setColorMap(Float min, Float max) {
+            _colorMin = min;
+            _colorMax = max;
+            _styleChanged = true;
+            return *this;
+        }
+        Float colorMin() const { return _colorMin; }
+        Float colorMax() const { return _colorMax; }
+
+        void bindBuffer() { _buffer.bind(GL::Buffer::Target::ShaderStorage, Binding); }
+
+    private:
+        GL::Buffer _buffer{GL::Buffer::TargetHint::ShaderStorage};
+        std::size_t _count;
+        const char* _origins;
+        const char* _vectors;
+        std::ptrdiff_t _originStride, _vectorStride;
+        std::vector<float> _arrows, _scratch;
+        Float _scale{1.0f}, _radius{0.01f};
+        Color3 _color{1.0f};
+        Float _colorMin{}, _colorMax{};
+        bool _styleChanged{};
+};
+
+}
+
+#endif
@@ -1,17 +1,29 @@
 #ifndef __magnumVisualizer_h_
 #define __magnumVisualizer_h_
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <thread>
+#include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/Reference.h>
 #include <Corrade/Utility/Resource.h>
 #include <Magnum/Image.h>
 #include <Magnum/PixelFormat.h>
 #include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/OpenGL.h>
+#include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderbuffer.h>
 #include <Magnum/GL/RenderbufferFormat.h>
 #include <Magnum/GL/Renderer.h>
@@ -20,8 +32,14 @@
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/GL/Version.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Frustum.h>
 #include <Magnum/MeshTools/Compile.h>
+#ifdef MAGNUM_VISUALIZER_HEADLESS
+#include <Magnum/Platform/WindowlessEglApplication.h>
+#else
 #include <Magnum/Platform/Sdl2Application.h>
+#endif
 #include <Magnum/Primitives/Cube.h>
 #include <Magnum/Primitives/Cylinder.h>
 #include <Magnum/Primitives/Plane.h>
@@ -37,6 +55,24 @@
 #include <Magnum/Shaders/visibility.h>
 #include <Magnum/DimensionTraits.h>
 #include <chrono>
+#include <cmath>
+#include "DynamicAabbTree.h"
+#include "FrameCapture.h"
+#include "FrameTimings.h"
+#include "MeshCache.h"
+#include "ObjectPool.h"
+#include "PoseLog.h"
+#include "PoseStream.h"
+#include "PoseTable.h"
+#include "RenderQueue.h"
+#include "ShaderCache.h"
+#include "SharedPoses.h"
+#include "StreamingBuffer.h"
+#include "TrailBuffer.h"
+#include "TransformHierarchy.h"
+#include "TriangleBvh.h"
+#include "TripleBuffer.h"
+#include "VectorField.h"
 
 namespace Magnum {
 
@@ -60,69 +96,39 @@ class PhongIdShader: public GL::AbstractShaderProgram {
 
         explicit PhongIdShader();
 
-        PhongIdShader& setObjectId(UnsignedInt id) {
-            setUniform(_objectIdUniform, id);
-            return *this;
-        }
-
-        PhongIdShader& setLightPosition(const Vector3& position) {
-            setUniform(_lightPositionUniform, position);
-            return *this;
-        }
-
-        PhongIdShader& setAmbientColor(const Color3& color) {
-            setUniform(_ambientColorUniform, color);
-            return *this;
-        }
-
-        PhongIdShader& setColor(const Color3& color) {
-            setUniform(_colorUniform, color);
-            return *this;
-        }
-
-        PhongIdShader& setTransformationMatrix(const Matrix4& matrix) {
-            setUniform(_transformationMatrixUniform, matrix);
-            return *this;
-        }
-
-        PhongIdShader& setNormalMatrix(const Matrix3x3& matrix) {
-            setUniform(_normalMatrixUniform, matrix);
-            return *this;
-        }
-
-        PhongIdShader& setProjectionMatrix(const Matrix4& matrix) {
-            setUniform(_projectionMatrixUniform, matrix);
+        /* Index of the object in the ObjectData buffer, everything else comes
+           from the FrameUniforms and ObjectData buffers */
+        PhongIdShader& setObjectIndex(UnsignedInt index) {
+            setUniform(_objectIndexUniform, index);
             return *this;
         }
 
     private:
-        Int _objectIdUniform,
-            _lightPositionUniform,
-            _ambientColorUniform,
-            _colorUniform,
-            _transformationMatrixUniform,
-            _normalMatrixUniform,
-            _projectionMatrixUniform;
+        Int _objectIndexUniform;
 };
 
 PhongIdShader::PhongIdShader() {
     Utility::Resource rs("picking-data");
+    const std::string frame = rs.get("frame.glsl"),
+        vertSource = rs.get("PhongId.vert"),
+        fragSource = rs.get("PhongId.frag");
+
+    const std::string key = ShaderCache::key({frame, vertSource, fragSource});
+    if(!ShaderCache::global().load(*this, key)) {
+        const auto start = ShaderCache::Clock::now();
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
+            frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addSource(frame);
+        vert.addSource(vertSource);
+        frag.addSource(fragSource);
+        CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+        ShaderCache::prepare(*this);
+        CORRADE_INTERNAL_ASSERT(link());
+        ShaderCache::global().store(*this, key, start);
+    }
 
-    GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
-        frag{GL::Version::GL430, GL::Shader::Type::Fragment};
-    vert.addSource(rs.get("PhongId.vert"));
-    frag.addSource(rs.get("PhongId.frag"));
-    CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
-    attachShaders({vert, frag});
-    CORRADE_INTERNAL_ASSERT(link());
-
-    _objectIdUniform = uniformLocation("objectId");
-    _lightPositionUniform = uniformLocation("light");
-    _ambientColorUniform = uniformLocation("ambientColor");
-    _colorUniform = uniformLocation("color");
-    _transformationMatrixUniform = uniformLocation("transformationMatrix");
-    _projectionMatrixUniform = uniformLocation("projectionMatrix");
-    _normalMatrixUniform = uniformLocation("normalMatrix");
+    _objectIndexUniform = uniformLocation("objectIndex");
 }
 
 class VertexColorId: public GL::AbstractShaderProgram //Shaders::VertexColor<3>//,
@@ -162,177 +168,1131 @@ public:
         ObjectIdOutput = 1
     };
   explicit VertexColorId();
-  VertexColorId& setObjectId(UnsignedInt id) {
-      setUniform(_objectIdUniform, id);
-      return *this;
-  }
-  VertexColorId& setTransformationMatrix(const Matrix4& matrix) {
-      setUniform(_transformationProjectionMatrixUniform, matrix);
-      // setUniform(_transformationMatrixUniform, matrix);
-      return *this;
-  }
-  VertexColorId& setBrightness(const float v) {
-      setUniform(_brightness, v);
-      // setUniform(_transformationMatrixUniform, matrix);
+  /* Same as PhongIdShader::setObjectIndex() */
+  VertexColorId& setObjectIndex(UnsignedInt index) {
+      setUniform(_objectIndexUniform, index);
       return *this;
   }
 private:
     Int
-    _objectIdUniform,
-    _transformationProjectionMatrixUniform{0},
-    _brightness;
+    _objectIndexUniform;
 };
 
 VertexColorId::VertexColorId(){
     Utility::Resource rs("picking-data");
+    const std::string generic = rs.get("generic.glsl"),
+        frame = rs.get("frame.glsl"),
+        vertSource = rs.get("VertexColorId.vert"),
+        fragSource = rs.get("VertexColorId.frag");
+
+    const std::string key = ShaderCache::key({generic, frame, vertSource, fragSource});
+    if(!ShaderCache::global().load(*this, key)) {
+        const auto start = ShaderCache::Clock::now();
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
+            frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addSource(generic);
+        vert.addSource(frame);
+        vert.addSource(vertSource);
+        frag.addSource(fragSource);
+        CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+
+        {
+            bindAttributeLocation(Position::Location, "position");
+            bindAttributeLocation(Color3::Location, "color"); /* Color4 is the same */
+        }
 
-    GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
-        frag{GL::Version::GL430, GL::Shader::Type::Fragment};
-    vert.addSource(rs.get("generic.glsl"));
-    vert.addSource(rs.get("VertexColorId.vert"));
-    frag.addSource(rs.get("VertexColorId.frag"));
-    CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
-    attachShaders({vert, frag});
+        ShaderCache::prepare(*this);
+        CORRADE_INTERNAL_ASSERT(link());
+        ShaderCache::global().store(*this, key, start);
+    }
 
-    {
-        bindAttributeLocation(Position::Location, "position");
-        bindAttributeLocation(Color3::Location, "color"); /* Color4 is the same */
+    _objectIndexUniform = uniformLocation("objectIndex");
+};
+
+/* Per-frame constants of all shaders, std140 layout matching frame.glsl */
+struct FrameUniforms {
+    enum: UnsignedInt { Binding = 0 };
+
+    Matrix4 projectionMatrix;
+    /* Relative to the camera, w is unused */
+    Vector4 light;
+};
+
+/* Per-object data of the non-instanced shaders, one entry per drawn
+   PickableObject. std430 layout matching frame.glsl. */
+struct ObjectData {
+    enum: UnsignedInt { Binding = 1 };
+
+    Matrix4 transformationMatrix;
+    Color3 color;
+    UnsignedInt objectId;
+    Float selected;
+    Float padding[3];
+};
+
+static_assert(sizeof(ObjectData) == 96, "ObjectData doesn't match the std430 layout");
+
+/* Per-instance data of the instanced shaders, one entry per PickableObject.
+   Layout has to match the attribute definitions below. */
+struct InstanceData {
+    Matrix4 transformationMatrix;
+    Color3 color;
+    UnsignedInt objectId;
+    Float selected;
+};
+
+class PhongIdInstancedShader: public GL::AbstractShaderProgram {
+    public:
+        typedef Shaders::Generic3D::Position Position;
+        typedef Shaders::Generic3D::Normal Normal;
+
+        /* Per-instance attributes, keep consistent with generic.glsl */
+        typedef GL::Attribute<5, Matrix4> TransformationMatrix;
+        typedef GL::Attribute<9, Color3> InstanceColor;
+        typedef GL::Attribute<10, UnsignedInt> ObjectId;
+        typedef GL::Attribute<11, Float> Selected;
+
+        enum: UnsignedInt {
+            ColorOutput = 0,
+            ObjectIdOutput = 1
+        };
+
+        /* Projection and light come from the FrameUniforms buffer */
+        explicit PhongIdInstancedShader();
+};
+
+PhongIdInstancedShader::PhongIdInstancedShader() {
+    Utility::Resource rs("picking-data");
+    const std::string generic = rs.get("generic.glsl"),
+        frame = rs.get("frame.glsl"),
+        vertSource = rs.get("PhongIdInstanced.vert"),
+        fragSource = rs.get("PhongIdInstanced.frag");
+
+    const std::string key = ShaderCache::key({generic, frame, vertSource, fragSource});
+    if(!ShaderCache::global().load(*this, key)) {
+        const auto start = ShaderCache::Clock::now();
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
+            frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addSource(generic);
+        vert.addSource(frame);
+        vert.addSource(vertSource);
+        frag.addSource(fragSource);
+        CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+        ShaderCache::prepare(*this);
+        CORRADE_INTERNAL_ASSERT(link());
+        ShaderCache::global().store(*this, key, start);
     }
+}
+
+class VertexColorIdInstanced: public GL::AbstractShaderProgram {
+    public:
+        typedef Shaders::Generic3D::Position Position;
+        typedef Shaders::Generic3D::Color4 Color4;
+
+        /* Same per-instance layout as PhongIdInstancedShader so both can be
+           fed from the same InstanceData buffer */
+        typedef PhongIdInstancedShader::TransformationMatrix TransformationMatrix;
+        typedef PhongIdInstancedShader::InstanceColor InstanceColor;
+        typedef PhongIdInstancedShader::ObjectId ObjectId;
+        typedef PhongIdInstancedShader::Selected Selected;
+
+        enum: UnsignedInt {
+            ColorOutput = 0,
+            ObjectIdOutput = 1
+        };
+
+        explicit VertexColorIdInstanced();
+};
+
+VertexColorIdInstanced::VertexColorIdInstanced() {
+    Utility::Resource rs("picking-data");
+    const std::string generic = rs.get("generic.glsl"),
+        frame = rs.get("frame.glsl"),
+        vertSource = rs.get("VertexColorIdInstanced.vert"),
+        fragSource = rs.get("VertexColorIdInstanced.frag");
+
+    const std::string key = ShaderCache::key({generic, frame, vertSource, fragSource});
+    if(!ShaderCache::global().load(*this, key)) {
+        const auto start = ShaderCache::Clock::now();
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
+            frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addSource(generic);
+        vert.addSource(frame);
+        vert.addSource(vertSource);
+        frag.addSource(fragSource);
+        CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+        ShaderCache::prepare(*this);
+        CORRADE_INTERNAL_ASSERT(link());
+        ShaderCache::global().store(*this, key, start);
+    }
+}
+
+/* Draws all trails of a TrailBuffer, fetching the samples by vertex ID */
+class TrailShader: public GL::AbstractShaderProgram {
+    public:
+        enum: UnsignedInt {
+            ColorOutput = 0,
+            ObjectIdOutput = 1
+        };
+
+        explicit TrailShader();
+
+        TrailShader& setTransformationMatrix(const Matrix4& matrix) {
+            setUniform(_transformationMatrixUniform, matrix);
+            return *this;
+        }
+        TrailShader& setRing(const TrailBuffer& trails) {
+            setUniform(_sampleCountUniform, trails.sampleCount());
+            setUniform(_trailLengthUniform, trails.length());
+            setUniform(_trailStrideUniform, trails.capacity());
+            return *this;
+        }
+
+    private:
+        Int _transformationMatrixUniform,
+            _sampleCountUniform,
+            _trailLengthUniform,
+            _trailStrideUniform;
+};
+
+TrailShader::TrailShader() {
+    Utility::Resource rs("picking-data");
+    const std::string frame = rs.get("frame.glsl"),
+        vertSource = rs.get("Trail.vert"),
+        fragSource = rs.get("Trail.frag");
+
+    const std::string key = ShaderCache::key({frame, vertSource, fragSource});
+    if(!ShaderCache::global().load(*this, key)) {
+        const auto start = ShaderCache::Clock::now();
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
+            frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addSource(frame);
+        vert.addSource(vertSource);
+        frag.addSource(fragSource);
+        CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+        ShaderCache::prepare(*this);
+        CORRADE_INTERNAL_ASSERT(link());
+        ShaderCache::global().store(*this, key, start);
+    }
+
+    _transformationMatrixUniform = uniformLocation("transformationMatrix");
+    _sampleCountUniform = uniformLocation("sampleCount");
+    _trailLengthUniform = uniformLocation("trailLength");
+    _trailStrideUniform = uniformLocation("trailStride");
+}
+
+/* Draws all arrows of a VectorField, generating the geometry by vertex ID */
+class ArrowShader: public GL::AbstractShaderProgram {
+    public:
+        enum: UnsignedInt {
+            ColorOutput = 0,
+            ObjectIdOutput = 1
+        };
 
-    CORRADE_INTERNAL_ASSERT(link());
+        explicit ArrowShader();
 
-    _objectIdUniform = uniformLocation("objectId");
-    _brightness = uniformLocation("brightness");
+        ArrowShader& setTransformationMatrix(const Matrix4& matrix) {
+            setUniform(_transformationMatrixUniform, matrix);
+            return *this;
+        }
+        ArrowShader& setStyle(const VectorField& field) {
+            setUniform(_scaleUniform, field.scale());
+            setUniform(_radiusUniform, field.radius());
+            setUniform(_colorUniform, field.color());
+            setUniform(_colorRangeUniform, Vector2{field.colorMin(), field.colorMax()});
+            return *this;
+        }
+
+    private:
+        Int _transformationMatrixUniform,
+            _scaleUniform,
+            _radiusUniform,
+            _colorUniform,
+            _colorRangeUniform;
 };
 
+ArrowShader::ArrowShader() {
+    Utility::Resource rs("picking-data");
+    const std::string frame = rs.get("frame.glsl"),
+        vertSource = rs.get("Arrow.vert"),
+        fragSource = rs.get("Arrow.frag");
+
+    const std::string key = ShaderCache::key({frame, vertSource, fragSource});
+    if(!ShaderCache::global().load(*this, key)) {
+        const auto start = ShaderCache::Clock::now();
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex},
+            frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addSource(frame);
+        vert.addSource(vertSource);
+        frag.addSource(fragSource);
+        CORRADE_INTERNAL_ASSERT(GL::Shader::compile({vert, frag}));
+        attachShaders({vert, frag});
+        ShaderCache::prepare(*this);
+        CORRADE_INTERNAL_ASSERT(link());
+        ShaderCache::global().store(*this, key, start);
+    }
+
+    _transformationMatrixUniform = uniformLocation("transformationMatrix");
+    _scaleUniform = uniformLocation("scale");
+    _radiusUniform = uniformLocation("radius");
+    _colorUniform = uniformLocation("color");
+    _colorRangeUniform = uniformLocation("colorRange");
+}
+
 enum pickableShaders {phongShader, colorshader};
 
+/* Tessellation levels of a primitive, finest first */
+struct MeshLodChain {
+    enum: std::size_t { MaxLevels = 3 };
+    GL::Mesh* meshes[MaxLevels];
+    UnsignedInt triangleCounts[MaxLevels];
+    std::size_t levelCount;
+};
+
 class PickableObject: public Object3D, SceneGraph::Drawable3D {
     public:
-        explicit PickableObject(unsigned int id, PhongIdShader* shader, const Color3& color, GL::Mesh& mesh, Object3D& parent, SceneGraph::DrawableGroup3D& drawables): Object3D{&parent}, SceneGraph::Drawable3D{*this, &drawables}, _id{id}, _selected{false}, _phongShader(shader), _color{color}, _mesh(mesh), _shaderType(phongShader),  _vertexShader(nullptr) {}
-        explicit PickableObject(unsigned int id, VertexColorId* shader, const Color3& color, GL::Mesh& mesh, Object3D& parent, SceneGraph::DrawableGroup3D& drawables): Object3D{&parent}, SceneGraph::Drawable3D{*this, &drawables}, _id{id}, _selected{false}, _vertexShader(shader), _color{color}, _mesh(mesh), _shaderType(colorshader), _phongShader(nullptr) {}
+        /* Constructed by ObjectPool with the slot index, the ID written to
+           the ID buffer is one more as 0 means no object. Not put in any
+           drawable group, the visualizer keeps its own draw lists and
+           removal from a group would be linear. */
+        explicit PickableObject(UnsignedInt index, PhongIdShader* shader, const Color3& color, GL::Mesh& mesh, Object3D& parent): Object3D{&parent}, SceneGraph::Drawable3D{*this}, _id{index + 1}, _selected{false}, _phongShader(shader), _color{color}, _mesh(mesh), _shaderType(phongShader),  _vertexShader(nullptr) {}
+        explicit PickableObject(UnsignedInt index, VertexColorId* shader, const Color3& color, GL::Mesh& mesh, Object3D& parent): Object3D{&parent}, SceneGraph::Drawable3D{*this}, _id{index + 1}, _selected{false}, _vertexShader(shader), _color{color}, _mesh(mesh), _shaderType(colorshader), _phongShader(nullptr) {}
 
         void setSelected(bool selected) { _selected = selected; }
-        unsigned int getId(){ return _id;}
+        UnsignedInt getId(){ return _id;}
+        pickableShaders shaderType() const { return _shaderType; }
+        GL::Mesh& mesh() { return _mesh; }
+
+        /* Row in the bound pose table, -1 if the pose isn't bound */
+        void setBoundRow(int row) { _boundRow = row; }
+        int boundRow() const { return _boundRow; }
+        /* Position in the instance batch objects list */
+        void setBatchIndex(std::size_t index) { _batchIndex = index; }
+        std::size_t batchIndex() const { return _batchIndex; }
+        /* TrailBuffer slot, -1 if the object has no trail */
+        void setTrail(int slot) { _trail = slot; }
+        int trail() const { return _trail; }
+
+        void setLodChain(const MeshLodChain* lods) {
+            _lods = lods;
+            _lod = 0;
+        }
+        const MeshLodChain* lodChain() const { return _lods; }
+        std::size_t lod() const { return _lod; }
+        /* Picks the level for the given projected bounding sphere radius in
+           pixels. thresholds[i] is the radius below which level i + 1 is
+           used; a level only changes once the radius is past the threshold
+           by the hysteresis fraction, so objects don't flicker at the
+           boundary. */
+        void updateLod(Float pixelRadius, const Float (&thresholds)[MeshLodChain::MaxLevels - 1], Float hysteresis) {
+            if(!_lods) return;
+            std::size_t target = 0;
+            while(target + 1 < _lods->levelCount && pixelRadius < thresholds[target]) ++target;
+            while(_lod < target && pixelRadius < thresholds[_lod]*(1.0f - hysteresis)) ++_lod;
+            while(_lod > target && pixelRadius > thresholds[_lod - 1]*(1.0f + hysteresis)) --_lod;
+        }
+        void resetLod() { _lod = 0; }
+        GL::Mesh& currentMesh() { return _lods ? *_lods->meshes[_lod] : _mesh; }
 
-    private:
-        virtual void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
+        /* Bounding sphere of the mesh, in object space */
+        void setLocalBounds(const Vector3& center, Float radius) {
+            _boundsCenter = center;
+            _boundsRadius = radius;
+        }
+        void worldBoundingSphere(const Matrix4& m, Vector3& center, Float& radius) const {
+            center = m.transformPoint(_boundsCenter);
+            radius = _boundsRadius*Math::max(Math::max(m.right().length(), m.up().length()), m.backward().length());
+        }
+
+        /* Shader inputs of the object for the given camera-relative
+           transformation, for the object buffer and the instanced path */
+        ObjectData objectData(const Matrix4& transformationMatrix) const {
+            return {transformationMatrix, _color, _id, _selected ? 1.0f : 0.0f, {}};
+        }
+        InstanceData instanceData(const Matrix4& transformationMatrix) const {
+            return {transformationMatrix, _color, _id, _selected ? 1.0f : 0.0f};
+        }
+
+        /* Where objectData() was written in the object buffer this frame */
+        void setDrawIndex(UnsignedInt index) { _drawIndex = index; }
+        /* Draws with the data at the draw index, the only uniform set */
+        void submit() {
             switch (_shaderType) {
                 case phongShader:
-                _phongShader->setTransformationMatrix(transformationMatrix)
-                    .setNormalMatrix(transformationMatrix.rotationScaling())
-                    .setProjectionMatrix(camera.projectionMatrix())
-                    .setAmbientColor(_selected ? _color*0.3f : Color3{})
-                    .setColor(_color*(_selected ? 2.0f : 1.0f))
-                    /* relative to the camera */
-                    .setLightPosition({13.0f, 2.0f, 5.0f})
-                    .setObjectId(_id);
-                _mesh.draw(*_phongShader);
+                currentMesh().draw(_phongShader->setObjectIndex(_drawIndex));
                 break;
                 case colorshader:
-                _vertexShader->setObjectId(_id)
-                .setTransformationMatrix(camera.projectionMatrix()*transformationMatrix)
-                .setBrightness(_selected ? 1.0f : 0.5f)
-                ;
-                _mesh.draw(*_vertexShader);
+                currentMesh().draw(_vertexShader->setObjectIndex(_drawIndex));
                 break;
             }
         }
 
-        unsigned int _id;
+    private:
+        /* The transformation was already written to the object buffer, see
+           magnumVisualizer::drawObjects() */
+        virtual void draw(const Matrix4&, SceneGraph::Camera3D&) { submit(); }
+
+        UnsignedInt _id;
         bool _selected;
         PhongIdShader* _phongShader;
         VertexColorId* _vertexShader;
         pickableShaders _shaderType;
         Color3 _color;
         GL::Mesh& _mesh;
+        const MeshLodChain* _lods{};
+        std::size_t _lod{};
+        Vector3 _boundsCenter;
+        Float _boundsRadius{};
+        UnsignedInt _drawIndex{};
+        int _boundRow{-1};
+        std::size_t _batchIndex{};
+        int _trail{-1};
 };
 
-class magnumVisualizer: public Platform::Application {
+#ifdef MAGNUM_VISUALIZER_HEADLESS
+/* Stand-in for the parts of Platform::Application the visualizer uses, on top
+   of a windowless EGL context. Works with Mesa's software GL on display-less
+   nodes. There are no input events, magnumVisualizer::exec() draws every
+   frame as fast as possible. */
+class HeadlessApplication: public Platform::WindowlessApplication {
     public:
-        explicit magnumVisualizer(const Arguments& arguments);
+        class Configuration {
+            public:
+                Configuration& setTitle(const std::string&) { return *this; }
+                Configuration& setSize(const Vector2i& size) {
+                    _size = size;
+                    return *this;
+                }
+                Vector2i size() const { return _size; }
 
-        int add3dAxisVisualization(float* pos, float* rot){
-            _objects.push_back(new PickableObject{_objects.size()+1, &_vertexShader, 0xa5c9ea_rgbf, _cube, _scene, _drawables});
-            _objectReferencedPos.insert(std::make_pair(_objects.back(), pos));
-            _objectReferencedRot.insert(std::make_pair(_objects.back(), rot));
-            return _objects.size()-1;
+            private:
+                Vector2i _size{800, 600};
         };
-        int add3dAxisGUI(float posx = 0.0, float posy = 0.0, float posz = 0.0){
-            _objects.push_back(new PickableObject{_objects.size()+1, &_vertexShader, 0xa5c9ea_rgbf, _cube, _scene, _drawables});
-            _objects.back()->translate(Vector3(posx, posy, posz));
 
-            for(auto* o: _objects) o->setSelected(false);
-            _objects.back()->setSelected(true);
-            _selectedPrimative = _objects.size()-1;
+        explicit HeadlessApplication(const Arguments& arguments, const Configuration& configuration = Configuration{}): Platform::WindowlessApplication{arguments}, _size{configuration.size()} {}
+
+        Vector2i framebufferSize() const { return _size; }
+
+        /* Stop after the given number of frames, 0 means until exit() */
+        void setFrameLimit(unsigned long long frames) { _frameLimit = frames; }
+
+    protected:
+        void exit(int exitCode = 0) {
+            _exitRequested = true;
+            _exitCode = exitCode;
+        }
+        void redraw() {}
+        void swapBuffers() {}
+        void setMinimalLoopPeriod(UnsignedInt) {}
+
+        virtual void tickEvent() {}
+        virtual void drawEvent() = 0;
+
+        Vector2i _size;
+        unsigned long long _frameLimit{};
+        bool _exitRequested{};
+        int _exitCode{};
+};
+
+typedef HeadlessApplication VisualizerApplication;
+#else
+typedef Platform::Application VisualizerApplication;
+#endif
 
-            return _objects.size()-1;
+class magnumVisualizer: public VisualizerApplication {
+    public:
+        /* Size of the window, or of the captured frames when headless */
+        explicit magnumVisualizer(const Arguments& arguments, const Vector2i& size = {800, 600});
+        /* Derived classes running the simulation thread should call
+           stopSimulationThread() in their own destructor, stateUpdate() is
+           no longer callable once it returns */
+        ~magnumVisualizer() {
+            stopSimulationThread();
+            /* Parented objects would be deleted by their parent, but they
+               live in the pool, which destroys them itself */
+            for(UnsignedInt i: _objects.live()) _objects[i]->setParent(&_scene);
+        }
+
+        /* Objects are referred to by handles, which turn invalid once the
+           object is removed, even if its storage gets reused */
+        ObjectHandle add3dAxisVisualization(float* pos, float* rot){
+            const std::vector<ObjectHandle> handles = add3dAxisVisualizations(1, pos, 0, rot, 0);
+            return handles.empty() ? ObjectHandle{} : handles.front();
+        };
+        /* Bind count objects at once, object i reads its position from
+           pos + i*posStride and rotation from rot + i*rotStride (strides in
+           bytes), so e.g. a std::vector of per-robot state structs can be
+           bound in place. Null pos or rot bind the origin or identity
+           rotation. Returns the handles of all objects, or none while the
+           bound rows can't change (see boundRowsFixed()). */
+        std::vector<ObjectHandle> add3dAxisVisualizations(std::size_t count, float* pos, std::ptrdiff_t posStride, float* rot, std::ptrdiff_t rotStride){
+            if(boundRowsFixed()) return {};
+            std::vector<ObjectHandle> handles(count);
+            const std::size_t firstRow = _boundPoses.bind(count, pos, posStride, rot, rotStride);
+            for(std::size_t i = 0; i != count; ++i) {
+                handles[i] = _objects.emplace(&_vertexShader, 0xa5c9ea_rgbf, _cube, _scene);
+                registerObject(handles[i], int(firstRow + i));
+            }
+            return handles;
+        };
+        ObjectHandle add3dAxisGUI(float posx = 0.0, float posy = 0.0, float posz = 0.0){
+            const ObjectHandle handle = _objects.emplace(&_vertexShader, 0xa5c9ea_rgbf, _cube, _scene);
+            _objects.get(handle)->translate(Vector3(posx, posy, posz));
+            registerObject(handle);
+            select({handle});
+            return handle;
         };
 
-        int addCylinder(float* pos, float* rot, const float s = 1.0f, const Color3 color = 0x3bd267_rgbf) {
-            _objects.push_back(new PickableObject{_objects.size()+1, &_phongShader, color, _cylinder, _scene, _drawables});
-            _objects.back()->scale(Vector3(s));
-            _objectReferencedPos.insert(std::make_pair(_objects.back(), pos));
-            _objectReferencedRot.insert(std::make_pair(_objects.back(), rot));
-            return _objects.size()-1;
+        ObjectHandle addCylinder(float* pos, float* rot, const float s = 1.0f, const Color3 color = 0x3bd267_rgbf) {
+            const std::vector<ObjectHandle> handles = addCylinders(1, pos, 0, rot, 0, s, color);
+            return handles.empty() ? ObjectHandle{} : handles.front();
+        }
+        /* Strided bulk variant of addCylinder(), same as
+           add3dAxisVisualizations() */
+        std::vector<ObjectHandle> addCylinders(std::size_t count, float* pos, std::ptrdiff_t posStride, float* rot, std::ptrdiff_t rotStride, const float s = 1.0f, const Color3 color = 0x3bd267_rgbf) {
+            if(boundRowsFixed()) return {};
+            std::vector<ObjectHandle> handles(count);
+            const std::size_t firstRow = _boundPoses.bind(count, pos, posStride, rot, rotStride);
+            for(std::size_t i = 0; i != count; ++i) {
+                handles[i] = _objects.emplace(&_phongShader, color, _cylinder, _scene);
+                _objects.get(handles[i])->scale(Vector3(s));
+                registerObject(handles[i], int(firstRow + i));
+            }
+            return handles;
+        }
+
+        /* Object showing a user mesh from an STL or OBJ file, drawn like the
+           cylinders. The file is converted on first use into a cache file of
+           GPU-ready vertex and index data (see MeshFile), later loads just
+           map it and upload it. Objects showing the same mesh share one GPU
+           copy, even if loaded from different paths with the same content.
+           Returns an invalid handle if the file can't be loaded. */
+        ObjectHandle addMesh(const std::string& path, float* pos, float* rot, const float s = 1.0f, const Color3 color = 0x2f83cc_rgbf) {
+            const std::vector<ObjectHandle> handles = addMeshes(path, 1, pos, 0, rot, 0, s, color);
+            return handles.empty() ? ObjectHandle{} : handles.front();
+        }
+        /* Strided bulk variant of addMesh(), same as add3dAxisVisualizations().
+           Returns no handles if the file can't be loaded. */
+        std::vector<ObjectHandle> addMeshes(const std::string& path, std::size_t count, float* pos, std::ptrdiff_t posStride, float* rot, std::ptrdiff_t rotStride, const float s = 1.0f, const Color3 color = 0x2f83cc_rgbf) {
+            if(boundRowsFixed()) return {};
+            GL::Mesh* mesh = loadMesh(path);
+            if(!mesh) return {};
+            std::vector<ObjectHandle> handles(count);
+            const std::size_t firstRow = _boundPoses.bind(count, pos, posStride, rot, rotStride);
+            for(std::size_t i = 0; i != count; ++i) {
+                handles[i] = _objects.emplace(&_phongShader, color, *mesh, _scene);
+                _objects.get(handles[i])->scale(Vector3(s));
+                registerObject(handles[i], int(firstRow + i));
+            }
+            return handles;
         }
-        bool getPos(int id, float pos[3]);
-        bool getRot(int id, float rot[9]);
+        /* Where mesh cache files are written, next to the source files if
+           empty. Takes effect for meshes not loaded yet. */
+        void setMeshCacheDirectory(const std::string& directory) { _meshCacheDirectory = directory; }
+        /* Distinct user meshes on the GPU */
+        std::size_t userMeshCount() const { return _userMeshes.size(); }
+
+        /* Removes the object and its pose binding, culling and batching
+           entries and selection. Constant time except for the culling tree
+           update, which is logarithmic. Returns false if the handle is
+           stale, or if the pose is bound while boundRowsFixed(). */
+        bool remove(ObjectHandle handle);
+        /* Whether bound objects can't be added or removed right now, as
+           poses come in rows of a fixed count from elsewhere: while the
+           simulation thread or the pose receiver runs, shared poses are
+           attached, or while recording or playing back, as rows are matched
+           to objects by index */
+        bool boundRowsFixed() const {
+            return isSimulationThreadRunning() || isPoseReceiverRunning() ||
+                isSharedPosesAttached() || isRecording() || isPlayingBack();
+        }
+        bool isValid(ObjectHandle handle) const { return _objects.get(handle); }
+        std::size_t objectCount() const { return _objects.size(); }
+
+        /* Attaches an object to another one, its pose (bound or not) is then
+           relative to the parent, e.g. for the links of an articulated
+           robot. A default-constructed parent handle attaches it back to the
+           scene. World transformations of the whole hierarchy are computed
+           level by level on a thread pool before each frame, only for
+           objects whose pose or some ancestor's pose changed. Removing an
+           object attaches its children to the scene, keeping their world
+           transformation. Returns false for stale handles or if parent is
+           the object itself or one of its descendants. */
+        bool setParent(ObjectHandle handle, ObjectHandle parent);
+        /* Depth of the deepest object as of the last frame, 1 if no object
+           has a parent */
+        std::size_t hierarchyLevelCount() const { return _transforms.levelCount(); }
+
+        /* Trajectory trail of an object with a bound pose, its position is
+           recorded every tick any bound pose changes. All trails share one
+           GPU ring buffer of the same length, each tick uploads only the
+           newest sample of every trail and all trails are drawn with one
+           draw call. Returns false if the object isn't bound or already has
+           a trail. */
+        bool addTrail(ObjectHandle handle, const Color3& color = 0xdcdcdc_rgbf);
+        bool removeTrail(ObjectHandle handle);
+        /* Samples kept per trail, discards the recorded history */
+        void setTrailLength(UnsignedInt samples) {
+            _trails.setLength(samples);
+            requestRedraw();
+        }
+        UnsignedInt trailLength() const { return _trails.length(); }
+        std::size_t trailCount() const { return _trails.size(); }
+
+        /* Arrows from count origins and vectors in user memory, arrow i
+           starts at origins + i*originStride and points along
+           vectors + i*vectorStride (strides in bytes). Read every tick like
+           bound poses, uploaded only if anything changed and drawn with one
+           instanced draw call per field, so fields of 100k+ arrows stay
+           interactive. Style it through vectorField(), rebind it there when
+           the count or the arrays change. With the simulation thread
+           running the arrays are copied right after every update like the
+           bound poses, so fields have to be added, removed and rebound
+           before it's started. Returns the field ID. */
+        int addVectorField(std::size_t count, const float* origins, std::ptrdiff_t originStride, const float* vectors, std::ptrdiff_t vectorStride, Float scale = 1.0f, const Color3& color = 0xcd3431_rgbf);
+        bool removeVectorField(int field);
+        /* Null for removed or invalid IDs */
+        VectorField* vectorField(int field) {
+            return field >= 0 && std::size_t(field) < _vectorFields.size() ? _vectorFields[field].get() : nullptr;
+        }
+        std::size_t vectorFieldArrowCount() const {
+            std::size_t count = 0;
+            for(const auto& field: _vectorFields) if(field) count += field->size();
+            return count;
+        }
+
+        /* Return false if the handle is stale */
+        bool getPos(ObjectHandle handle, float pos[3]);
+        bool getRot(ObjectHandle handle, float rot[9]);
+
+        /* Draw all objects sharing a mesh and shader with a single instanced
+           draw call instead of one draw call per object */
+        void setInstancedRendering(bool enabled) {
+            _instancedRendering = enabled;
+            requestRedraw();
+        }
+        bool isInstancedRendering() const { return _instancedRendering; }
+
+        /* Skip objects outside of the view frustum before drawing. Object
+           bounds are kept in a dynamic AABB tree that's only touched for
+           objects whose pose changed. Toggled with the C key. */
+        void setFrustumCulling(bool enabled) {
+            _frustumCulling = enabled;
+            requestRedraw();
+        }
+        bool isFrustumCulling() const { return _frustumCulling; }
+
+        /* Draw cylinders and spheres with coarser tessellation the smaller
+           they are on screen. thresholds are the projected bounding sphere
+           radii in pixels below which the second and third level is used.
+           Toggled with the L key. */
+        void setLevelOfDetail(bool enabled) {
+            _levelOfDetail = enabled;
+            requestRedraw();
+        }
+        bool isLevelOfDetail() const { return _levelOfDetail; }
+        void setLodThresholds(Float level1, Float level2, Float hysteresis = 0.2f) {
+            _lodThresholds[0] = level1;
+            _lodThresholds[1] = level2;
+            _lodHysteresis = hysteresis;
+            requestRedraw();
+        }
+        /* Triangle counts of all levels, finest first */
+        const MeshLodChain& cylinderLods() const { return _meshLods.at(&_cylinder); }
+        const MeshLodChain& sphereLods() const { return _meshLods.at(&_sphere); }
+        /* Visible objects drawn at given level in the last frame, only
+           counting objects that have levels, summed over all views */
+        std::size_t lodObjectCount(std::size_t level) const { return _lodObjectCounts[level]; }
+        /* Objects that passed culling in the last drawn frame, summed over
+           all views */
+        std::size_t visibleObjectCount() const { return _visibleObjectTotal; }
+
+        /* Draw objects ordered by shader, mesh and then front to back
+           instead of in the order they were added. Toggled with the R key,
+           doesn't affect instanced rendering. */
+        void setDrawSorting(bool enabled) {
+            _drawSorting = enabled;
+            requestRedraw();
+        }
+        bool isDrawSorting() const { return _drawSorting; }
+        /* Shader and mesh switches in the last non-instanced frame, the first
+           draw of each view counts as one of each */
+        std::size_t stateChangeCount() const { return _stateChangeCount; }
+
+        /* Draw frames straight to the window without the object ID output
+           and the blit from the offscreen framebuffer. The ID buffer is then
+           only rendered when a pick is requested, scissored to the picked
+           region. Toggled with the B key, headless builds always render
+           offscreen. */
+        void setLazyIdPass(bool enabled) {
+            _lazyIdPass = enabled;
+            requestRedraw();
+        }
+        bool isLazyIdPass() const { return _lazyIdPass; }
+
+        /* Frames are only drawn when a bound pose, the camera or the
+           selection changed, ticks without any change are counted as
+           skipped. Headless builds draw every tick, so framesSkipped() stays
+           0 there. */
+        unsigned long long framesDrawn() const { return _framesDrawn; }
+        unsigned long long framesSkipped() const { return _framesSkipped; }
+
+        /* Asynchronous picking. The object IDs under the given window
+           position or rectangle are read back into a pixel buffer and
+           resolved a frame or two later from tickEvent(), without stalling
+           the pipeline. The callback gets the sorted handles of all objects
+           found, as returned by the add*() functions; the same set is also
+           available through pickResult() once resolved. A left click picks
+           and selects a single object, a shift+left drag selects everything
+           in the dragged box. */
+        typedef std::function<void(const std::vector<ObjectHandle>&)> PickCallback;
+        void pick(const Vector2i& position, PickCallback callback = {}) {
+            pickRegion(Range2Di::fromSize(position, {1, 1}), std::move(callback));
+        }
+        void pickRegion(const Range2Di& rectangle, PickCallback callback = {});
+        /* Returns true and fills the handles if a pick was resolved since
+           the last call */
+        bool pickResult(std::vector<ObjectHandle>& objects) {
+            if(!_pickResultReady) return false;
+            objects = _pickResult;
+            _pickResultReady = false;
+            return true;
+        }
+
+        /* Picking on the CPU, without the ID buffer or any GPU readback, so
+           the result is immediate and also available headless. The ray is
+           tested against the culling tree of object bounds, which is refit
+           as poses change, and then against the triangles of the candidate
+           meshes through a per-mesh BVH built on first use. Line meshes
+           such as the axes are hit at their bounding sphere. With ray
+           picking enabled (toggled with the K key) a left click uses this
+           instead of the ID buffer, box selection still reads IDs. */
+        struct RayHit {
+            ObjectHandle object;
+            /* Along the normalized ray direction */
+            Float distance;
+            Vector3 point;
+        };
+        /* World-space ray, returns false if nothing was hit */
+        bool castRay(const Vector3& origin, const Vector3& direction, RayHit& hit);
+        /* Ray from the camera through a window position */
+        bool pickRay(const Vector2i& position, RayHit& hit);
+        void setRayPicking(bool enabled) { _rayPicking = enabled; }
+        bool isRayPicking() const { return _rayPicking; }
+
+        /* More cameras drawing the same scene, each into its own rectangle
+           of the window, in window coordinates with Y down like pick().
+           Objects, meshes, shaders and poses are shared, only culling, level
+           of detail selection and draw sorting are done once per view.
+           Views are drawn in ID order, a view overlapping earlier ones
+           replaces them in its rectangle. View 0 is the default camera and
+           covers the whole window until given a smaller viewport. Picking
+           and dragging the camera go to whichever view is under the mouse.
+           Returns the view ID. */
+        int addView(const Range2Di& viewport, const Matrix4& cameraTransformation, Deg fieldOfView = 35.0_degf);
+        /* View 0 can't be removed */
+        bool removeView(int view);
+        bool setViewport(int view, const Range2Di& viewport);
+        /* Null for removed or invalid IDs. The camera object can be moved
+           freely, its projection changed through the camera. */
+        Object3D* viewCameraObject(int view) {
+            return view >= 0 && std::size_t(view) < _views.size() ? _views[view].cameraObject : nullptr;
+        }
+        SceneGraph::Camera3D* viewCamera(int view) {
+            return view >= 0 && std::size_t(view) < _views.size() ? _views[view].camera : nullptr;
+        }
+        /* Makes the camera follow an object, keeping its current world
+           transformation, e.g. for a chase camera. A default-constructed
+           handle detaches it again. Removing the object detaches it too. */
+        bool attachView(int view, ObjectHandle object);
+        /* Topmost view under a window position, -1 if none */
+        int viewAt(const Vector2i& position) const;
+        std::size_t viewCount() const {
+            return std::size_t(std::count_if(_views.begin(), _views.end(),
+                [](const View& v) { return v.camera; }));
+        }
+
+        /* Run stateUpdate() at a fixed rate in Hz instead of once per tick.
+           Every tick runs as many steps as the real time elapsed since the
+           previous one calls for, at most maxStepsPerTick; time beyond that
+           is dropped so a slow frame doesn't snowball into ever more steps.
+           With fasterThanRealTime every tick runs maxStepsPerTick steps
+           regardless of the clock, e.g. for headless runs. A rate of 0
+           restores one step per tick. Doesn't affect the simulation
+           thread, which has its own rate. */
+        void setFixedTimestep(double rate, std::size_t maxStepsPerTick = 100, bool fasterThanRealTime = false) {
+            _timestepRate = rate;
+            _maxStepsPerTick = maxStepsPerTick ? maxStepsPerTick : 1;
+            _fasterThanRealTime = fasterThanRealTime;
+            _timestepAccumulator = 0.0;
+        }
+        /* Seconds of one step, 0 if stepping once per tick */
+        double timestep() const { return _timestepRate > 0.0 ? 1.0/_timestepRate : 0.0; }
+        /* stateUpdate() calls in the last tick */
+        std::size_t stepsLastTick() const { return _stepsLastTick; }
+        /* Simulated time per wall-clock time over the last second, 0 if
+           stepping once per tick */
+        double realTimeFactor() const { return _realTimeFactor; }
+
+        /* Run stateUpdate() on its own thread at the given rate in Hz (0
+           means as fast as possible) instead of inline in tickEvent(). The
+           bound poses are copied right after every update and handed to the
+           render thread through a lock-free triple buffer, so it never reads
+           the bound arrays while they are being written. Pause and single
+           stepping keep working. All objects have to be added before the
+           thread is started. */
+        void startSimulationThread(double rate = 0.0);
+        void stopSimulationThread();
+        bool isSimulationThreadRunning() const { return _simulationThread.joinable(); }
+
+        /* Drive the bound objects from poses another process publishes with
+           SharedPoseWriter, row i of a frame drives the i-th bound object.
+           Objects that only exist to be driven this way can be added with
+           null pos and rot pointers. Frames are gathered in place from the
+           mapping; torn frames are dropped and the next one is used
+           instead, frames whose row count doesn't match the bound objects
+           are skipped. Bound objects can't be added or removed while
+           attached, the writer's rows would refer to other objects. */
+        bool attachSharedPoses(const std::string& name) {
+            _sharedPoseStats = {};
+            return _sharedPoses.open(name);
+        }
+        void detachSharedPoses() { _sharedPoses.close(); }
+        bool isSharedPosesAttached() const { return _sharedPoses.isOpen(); }
+        struct SharedPoseStats {
+            unsigned long long frames, torn, busy, mismatched;
+        };
+        const SharedPoseStats& sharedPoseStats() const { return _sharedPoseStats; }
+
+        /* Drive the bound objects from pose batches sent to address with
+           PoseSender, see PoseStream.h for the protocol and address syntax.
+           A background thread decodes them and hands the latest state of all
+           rows over through a triple buffer, so the draw path never locks
+           and everything superseded by the time a tick comes is dropped.
+           Objects have to be added before starting, bound objects can't be
+           added or removed while it runs. */
+        bool startPoseReceiver(const std::string& address) {
+            std::vector<float> initial(_boundPoses.size()*PoseTable::SnapshotStride);
+            _boundPoses.gathered(initial.data());
+            return _poseReceiver.start(address, _boundPoses.size(), initial.data());
+        }
+        void stopPoseReceiver() { _poseReceiver.stop(); }
+        bool isPoseReceiverRunning() const { return _poseReceiver.isRunning(); }
+        PoseReceiver::Stats poseReceiverStats() const { return _poseReceiver.stats(); }
+
+        /* Append the bound poses of every tick in which any of them changed
+           to a pose log, see PoseLog.h for the format. Bound objects can't
+           be added or removed while recording. */
+        bool startRecording(const std::string& path) {
+            _recordingStart = std::chrono::steady_clock::now();
+            return _recorder.open(path);
+        }
+        void stopRecording() { _recorder.close(); }
+        bool isRecording() const { return _recorder.isOpen(); }
+
+        /* Drive the bound objects from a pose log instead of the bound
+           memory. The log is memory-mapped and frames are gathered straight
+           from the mapping, so it can be larger than RAM. Unless the
+           simulation thread runs, stateUpdate() isn't called while playing
+           back. Pause stops the playback clock and
+           single stepping moves one frame in the direction of the playback
+           speed, negative speeds play backwards. Frames recorded with a
+           different number of bound objects are skipped, bound objects
+           can't be added or removed while playing back. */
+        bool startPlayback(const std::string& path);
+        void stopPlayback() { _player.close(); }
+        bool isPlayingBack() const { return _player.isOpen(); }
+        void seekPlayback(std::size_t frame);
+        void setPlaybackSpeed(double speed) { _playbackSpeed = speed; }
+        double playbackSpeed() const { return _playbackSpeed; }
+        std::size_t playbackFrame() const { return _playbackFrame; }
+        std::size_t playbackFrameCount() const { return _player.frameCount(); }
+
+        /* Stream every everyNth-th drawn frame as raw RGBA8 to output, see
+           FrameCapture::open() for the output syntax. Frames have the window
+           size, or the size passed to the constructor when headless. */
+        bool startCapture(const std::string& output, UnsignedInt everyNth = 1) {
+            return _capture.open(output, everyNth);
+        }
+        void stopCapture() { _capture.close(); }
+
+        #ifdef MAGNUM_VISUALIZER_HEADLESS
+        int exec() override;
+        #endif
+
+        /* Per-phase timings of the most recent frames. Recorded only while
+           timeStateUpdates is set; the T key prints a summary. */
+        const FrameTimings& frameTimings() const { return _frameTimings; }
+        /* Writes JSON if path ends with .json, CSV otherwise */
+        bool dumpFrameTimings(const std::string& path) const {
+            std::ofstream out{path};
+            if(!out) return false;
+            if(path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0)
+                _frameTimings.writeJson(out);
+            else _frameTimings.writeCsv(out);
+            return bool(out);
+        }
+
+        /* Program binary cache hits, misses and time saved by the shaders
+           of this process, also printed by the T key */
+        const ShaderCache::Stats& shaderCacheStats() const { return ShaderCache::global().stats(); }
+
         bool timeStateUpdates;
+
+    protected:
+        /* The individual frame phases, exposed for the benchmark */
+        void updateObjectStateFromReference();
+        void updateVectorFields();
+        void updateWorldTransforms();
+        void drawScene();
+        void resolvePicks();
+
     private:
+        struct View {
+            /* Null once removed */
+            Object3D* cameraObject;
+            SceneGraph::Camera3D* camera;
+            /* Window coordinates, Y down */
+            Range2Di viewport;
+        };
+
+        /* Where a frame or ID pass is drawn to */
+        enum class RenderTarget {
+            Window,
+            Framebuffer,
+            IdFramebuffer
+        };
+
+        struct PendingPick {
+            GL::BufferImage2D image{GL::PixelFormat::RedInteger, GL::PixelType::UnsignedInt};
+            GLsync fence;
+            PickCallback callback;
+        };
+
+        struct InstanceBatch {
+            /* One instanced draw per level of detail */
+            struct Level {
+                GL::Mesh mesh{NoCreate};
+                GL::Buffer instanceBuffer;
+                std::vector<InstanceData> instanceData;
+            };
+
+            Level levels[MeshLodChain::MaxLevels];
+            std::size_t levelCount;
+            pickableShaders shaderType;
+            std::vector<PickableObject*> objects;
+        };
+
+        /* GPU copy of a user mesh, attached to every mesh drawing it. The
+           cache file stays mapped for ray picking, pages the CPU never
+           touches cost no memory. */
+        struct MeshBuffers {
+            GL::Buffer vertices{GL::Buffer::TargetHint::Array};
+            GL::Buffer indices{GL::Buffer::TargetHint::ElementArray};
+            UnsignedInt indexCount;
+            std::unique_ptr<MeshFile> file;
+        };
+
         void drawEvent() override;
+        #ifndef MAGNUM_VISUALIZER_HEADLESS
         void mousePressEvent(MouseEvent& event) override;
         void mouseMoveEvent(MouseMoveEvent& event) override;
         void mouseReleaseEvent(MouseEvent& event) override;
         void keyPressEvent(KeyEvent& event) override;
+        void exitEvent(ExitEvent& event) override {
+            stopSimulationThread();
+            event.setAccepted();
+        }
+        #endif
         void tickEvent() override {
-          if(!m_pause || (m_pause && m_stepOneFrame)){
-            if(timeStateUpdates){
-              auto t1 = std::chrono::high_resolution_clock::now();
-              stateUpdate();
-              auto t2 = std::chrono::high_resolution_clock::now();
-
-              std::chrono::duration<double, std::nano> fp_ns = t2 - t1;
-              _avgStateUpdateTime += 1E-2*(fp_ns.count()-_avgStateUpdateTime);
-              std::cout << "stateUpdate() took " << fp_ns.count() << " nanoseconds, low pass avg = "<<_avgStateUpdateTime << std::endl;
-            }
-            else stateUpdate();
-            m_stepOneFrame = false;
-          }
+            resolvePicks();
+            /* With the simulation thread running, stepping happens there */
+            if(isPlayingBack()) advancePlayback();
+            else if(!isSimulationThreadRunning()) runTickSteps();
             // updateCameraLocation();
-            updateObjectStateFromReference();
+            {
+                FrameTimings::Scope t{_frameTimings, FrameTimings::ReferenceSync, timeStateUpdates};
+                updateObjectStateFromReference();
+                updateVectorFields();
+            }
+            /* Headless exec() draws after every tick, nothing is skipped */
+            #ifndef MAGNUM_VISUALIZER_HEADLESS
+            if(!_redrawRequested) ++_framesSkipped;
+            #endif
         };
+        /* Use instead of redraw() so skipped frames can be counted */
+        void requestRedraw() {
+            _redrawRequested = true;
+            redraw();
+        }
         virtual void stateUpdate() {};
+        void runStateUpdate(){
+            FrameTimings::Scope t{_frameTimings, FrameTimings::StateUpdate, timeStateUpdates};
+            stateUpdate();
+        }
+        void runTickSteps();
+        void simulationLoop();
+        void publishPoseSnapshot();
+        void publishVectorFieldSnapshot();
+        void advancePlayback();
+        void recordPoses(const float* snapshot);
         void updateCameraLocation();
-        void updateObjectStateFromReference();
+        void addPrimitive(GL::Mesh& mesh, Trade::MeshData3D&& data);
+        GL::Mesh* loadMesh(const std::string& path);
+        void attachMeshBuffers(GL::Mesh& mesh, MeshBuffers& buffers);
+        const TriangleBvh& meshBvh(GL::Mesh& mesh);
+        bool intersectObject(UnsignedInt index, const Vector3& origin, const Vector3& direction, Float maxDistance, Float& distance);
+        void registerObject(ObjectHandle handle, int boundRow = -1);
+        void addToInstanceBatch(PickableObject* object);
+        void removeFromInstanceBatch(PickableObject* object);
+        void select(const std::vector<ObjectHandle>& objects);
+        void transformationChanged(std::size_t index);
+        void updateCullBounds(std::size_t index);
+        void cull();
+        void addLod(GL::Mesh& mesh, Trade::MeshData3D&& data);
+        void selectLods();
+        GL::AbstractFramebuffer& renderTarget(RenderTarget target);
+        void clearTarget(RenderTarget target);
+        /* Window Y down to framebuffer Y up */
+        Range2Di framebufferRange(const Range2Di& windowRange) const;
+        void renderScene(RenderTarget target, const Range2Di& range);
+        void drawIdPass(const Range2Di& range);
+        void drawInstanced();
+        void drawObjects();
+        void appendTrailSamples();
+        void drawTrails();
+        void drawVectorFields();
 
         Scene3D _scene;
+        /* Of view 0 */
         Object3D* _cameraObject;
+        /* Of the view being drawn */
         SceneGraph::Camera3D* _camera;
-        SceneGraph::DrawableGroup3D _drawables;
+        /* Indexed by view ID */
+        std::vector<View> _views;
+        int _dragView;
 
         PhongIdShader _phongShader;
         VertexColorId _vertexShader;
+        PhongIdInstancedShader _phongInstancedShader;
+        VertexColorIdInstanced _vertexInstancedShader;
+        TrailShader _trailShader;
+        ArrowShader _arrowShader;
+        GL::Buffer _frameUniforms{GL::Buffer::TargetHint::Uniform};
+        StreamingBuffer<ObjectData> _objectData;
         GL::Mesh _cube, _plane, _sphere, _cylinder;
+        /* Source data of the meshes above, the instance batches compile their
+           own copy with the per-instance buffer attached */
+        std::map<GL::Mesh*, Trade::MeshData3D> _meshData;
+        std::map<std::pair<GL::Mesh*, pickableShaders>, InstanceBatch> _instanceBatches;
+        bool _instancedRendering;
+        /* Bounding sphere center and radius of the meshes above */
+        std::map<GL::Mesh*, std::pair<Vector3, Float>> _meshBounds;
+        /* Coarser levels of the meshes above, keyed by the finest one */
+        std::deque<GL::Mesh> _lodMeshes;
+        std::map<GL::Mesh*, MeshLodChain> _meshLods;
+        /* User meshes, one per distinct content hash */
+        std::deque<GL::Mesh> _userMeshes;
+        std::map<GL::Mesh*, MeshBuffers> _userMeshBuffers;
+        std::map<std::uint64_t, GL::Mesh*> _userMeshHashes;
+        std::map<std::string, GL::Mesh*> _userMeshPaths;
+        std::string _meshCacheDirectory;
+        /* Built on the first ray hitting a mesh, empty for line meshes */
+        std::map<GL::Mesh*, TriangleBvh> _meshBvhs;
+        bool _levelOfDetail;
+        Float _lodThresholds[MeshLodChain::MaxLevels - 1];
+        Float _lodHysteresis;
+        std::size_t _lodObjectCounts[MeshLodChain::MaxLevels];
+
+        /* Culling state, indexed by object slot */
+        DynamicAabbTree _cullTree;
+        std::vector<int> _cullProxies;
+        std::vector<unsigned char> _objectVisible;
+        std::vector<PickableObject*> _drawList;
+        RenderQueue _renderQueue;
+        bool _drawSorting;
+        std::size_t _stateChangeCount;
+        bool _frustumCulling;
+        /* Of the view being drawn, and of all views in the last frame */
+        std::size_t _visibleObjectCount, _visibleObjectTotal;
+        bool _redrawRequested;
+        unsigned long long _framesDrawn, _framesSkipped;
 
         // PickableObject* _objects[ObjectCount];
-        std::vector<PickableObject*> _objects;
-        std::map<PickableObject*, float*> _objectReferencedPos;
-        std::map<PickableObject*, float*> _objectReferencedRot;
+        /* Destroyed before the scene, which would delete the objects */
+        ObjectPool<PickableObject> _objects;
+        /* Objects with a pose bound to user memory, in PoseTable row order */
+        PoseTable _boundPoses;
+        std::vector<PickableObject*> _boundObjects;
+        std::vector<Matrix4> _boundTransformations;
+        /* World transformations, keyed by object slot */
+        TransformHierarchy _transforms;
+        ThreadPool _threadPool;
+
+        TrailBuffer _trails;
+        GL::Mesh _trailMesh{GL::MeshPrimitive::Lines};
+        /* Indexed by trail slot, null for unused slots */
+        std::vector<PickableObject*> _trailObjects;
+
+        /* Indexed by field ID, null for removed fields */
+        std::vector<std::unique_ptr<VectorField>> _vectorFields;
+        GL::Mesh _arrowMesh{GL::MeshPrimitive::Triangles};
+        /* Arrows of all fields in ID order, filled by the simulation thread */
+        TripleBuffer<std::vector<float>> _vectorFieldSnapshots;
+
+        std::thread _simulationThread;
+        std::atomic<bool> _simulationRunning;
+        double _simulationRate;
+
+        double _timestepRate, _timestepAccumulator;
+        std::size_t _maxStepsPerTick, _stepsLastTick;
+        bool _fasterThanRealTime;
+        std::chrono::steady_clock::time_point _lastStepTick, _realTimeWindowStart;
+        double _realTimeWindowSimulated, _realTimeFactor;
+        TripleBuffer<std::vector<float>> _poseSnapshots;
+
+        SharedPoseReader _sharedPoses;
+        PoseReceiver _poseReceiver;
+        SharedPoseStats _sharedPoseStats{};
+
+        PoseRecorder _recorder;
+        std::chrono::steady_clock::time_point _recordingStart;
+        std::vector<float> _recordBuffer;
+        PosePlayer _player;
+        std::size_t _playbackFrame;
+        /* Set when _playbackFrame changed and wasn't gathered yet */
+        bool _playbackPending;
+        double _playbackTime, _playbackSpeed;
+        std::chrono::steady_clock::time_point _playbackTick;
 
         GL::Framebuffer _framebuffer;
         GL::Renderbuffer _color, _objectId, _depth;
+        /* Object ID and depth only, for the lazy ID pass */
+        GL::Framebuffer _idFramebuffer;
+        bool _lazyIdPass;
+        FrameCapture _capture;
         float _cameraPosX, _cameraPosY, _cameraPosZ;
-        bool m_stepOneFrame;
-        bool m_pause;
+        /* Shared with the simulation thread */
+        std::atomic<bool> m_stepOneFrame;
+        std::atomic<bool> m_pause;
         int _selectedPrimative;
-        int _avgStateUpdateTime;
+        FrameTimings _frameTimings;
 
         Vector2i _previousMousePosition, _mousePressPosition;
+        bool _regionDrag;
+
+        std::deque<PendingPick> _pendingPicks;
+        std::vector<ObjectHandle> _pickResult;
+        bool _pickResultReady;
+        bool _rayPicking;
 };
-bool magnumVisualizer::getPos(int id, float pos[3]){
-    if(id >= 0 && id<_objects.size()){
-        Magnum::Math::Matrix4<float> ct = _objects[id]->transformationMatrix();
+bool magnumVisualizer::getPos(ObjectHandle handle, float pos[3]){
+    if(PickableObject* o = _objects.get(handle)){
+        Magnum::Math::Matrix4<float> ct = o->transformationMatrix();
         for(int j=0; j<3; j++)  pos[j] = ct.translation()[j];
         // std::cout << "id: "<< id << "pos[0] "<< cttranslation(0) << std::endl;
         return true;
@@ -340,9 +1300,9 @@ bool magnumVisualizer::getPos(int id, float pos[3]){
     else return false;
 };
 
-bool magnumVisualizer::getRot(int id, float rot[9]){
-    if(id >= 0 && id<_objects.size()){
-        Magnum::Math::Matrix4<float> ct = _objects[id]->transformationMatrix();
+bool magnumVisualizer::getRot(ObjectHandle handle, float rot[9]){
+    if(PickableObject* o = _objects.get(handle)){
+        Magnum::Math::Matrix4<float> ct = o->transformationMatrix();
         int k = 0;
         for(int j=0; j<3; j++)  rot[k++] = ct.right()[j];
         for(int j=0; j<3; j++)  rot[k++] = ct.up()[j];
@@ -356,55 +1316,347 @@ void magnumVisualizer::updateCameraLocation(){
     Magnum::Math::Matrix4<float>  ct = _cameraObject->transformationMatrix();
     ct.translation() = _cameraObject->transformationMatrix().rotation()*Vector3(_cameraPosX, _cameraPosY, _cameraPosZ);
     _cameraObject->setTransformation(ct);
-    redraw();
+    requestRedraw();
+}
+
+void magnumVisualizer::startSimulationThread(double rate){
+    if(isSimulationThreadRunning()) return;
+    _simulationRate = rate;
+    /* Publish the current state so there's something to show even when
+       starting paused */
+    publishPoseSnapshot();
+    publishVectorFieldSnapshot();
+    _simulationRunning = true;
+    _simulationThread = std::thread{&magnumVisualizer::simulationLoop, this};
+}
+
+void magnumVisualizer::stopSimulationThread(){
+    if(!isSimulationThreadRunning()) return;
+    _simulationRunning = false;
+    _simulationThread.join();
+}
+
+void magnumVisualizer::publishPoseSnapshot(){
+    std::vector<float>& snapshot = _poseSnapshots.writeBuffer();
+    snapshot.resize(_boundPoses.size()*PoseTable::SnapshotStride);
+    _boundPoses.snapshot(snapshot.data());
+    _poseSnapshots.publish();
+}
+
+void magnumVisualizer::publishVectorFieldSnapshot(){
+    if(_vectorFields.empty()) return;
+    std::vector<float>& snapshot = _vectorFieldSnapshots.writeBuffer();
+    snapshot.resize(vectorFieldArrowCount()*VectorField::FloatsPerArrow);
+    float* out = snapshot.data();
+    for(const auto& field: _vectorFields) if(field) {
+        field->snapshot(out);
+        out += field->size()*VectorField::FloatsPerArrow;
+    }
+    _vectorFieldSnapshots.publish();
+}
+
+void magnumVisualizer::runTickSteps(){
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - _lastStepTick).count();
+    _lastStepTick = now;
+
+    std::size_t steps;
+    if(m_pause) {
+        steps = m_stepOneFrame ? 1 : 0;
+        /* Don't catch up on the paused time once resumed */
+        _timestepAccumulator = 0.0;
+    } else if(_timestepRate <= 0.0) steps = 1;
+    else if(_fasterThanRealTime) steps = _maxStepsPerTick;
+    else {
+        _timestepAccumulator += elapsed;
+        steps = std::min(std::size_t(_timestepAccumulator*_timestepRate), _maxStepsPerTick);
+        _timestepAccumulator -= double(steps)/_timestepRate;
+        /* Over the cap, drop the backlog but keep the fractional step */
+        if(_timestepAccumulator*_timestepRate >= 1.0)
+            _timestepAccumulator = std::fmod(_timestepAccumulator, 1.0/_timestepRate);
+    }
+
+    if(steps) {
+        FrameTimings::Scope t{_frameTimings, FrameTimings::StateUpdate, timeStateUpdates};
+        for(std::size_t i = 0; i != steps; ++i) stateUpdate();
+    }
+    m_stepOneFrame = false;
+    _stepsLastTick = steps;
+
+    if(_timestepRate > 0.0) {
+        _realTimeWindowSimulated += double(steps)/_timestepRate;
+        const double window = std::chrono::duration<double>(now - _realTimeWindowStart).count();
+        if(window >= 1.0) {
+            _realTimeFactor = _realTimeWindowSimulated/window;
+            _realTimeWindowSimulated = 0.0;
+            _realTimeWindowStart = now;
+        }
+    } else _realTimeFactor = 0.0;
+}
+
+void magnumVisualizer::simulationLoop(){
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>{_simulationRate > 0.0 ? 1.0/_simulationRate : 0.0});
+    auto next = std::chrono::steady_clock::now();
+    while(_simulationRunning) {
+        const bool step = !m_pause || m_stepOneFrame;
+        if(step) {
+            runStateUpdate();
+            m_stepOneFrame = false;
+            publishPoseSnapshot();
+            publishVectorFieldSnapshot();
+        }
+
+        if(period.count() > 0) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        /* Don't spin while paused */
+        } else if(!step) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 }
 
 void magnumVisualizer::updateObjectStateFromReference(){
-    for(auto &p: _objectReferencedPos)
-    {
-        Magnum::Math::Matrix4<float>  ct = p.first->transformationMatrix();
-        ct.translation() = Vector3(p.second[0],p.second[1],p.second[2]);
-        p.first->setTransformation(ct);
+    /* Only touch scene-graph nodes whose bound pose changed since the last
+       tick and only redraw if any did. With the simulation thread running
+       the poses come from the latest complete snapshot it published. */
+    std::size_t changed;
+    const float* snapshot = nullptr;
+    if(isPlayingBack()) {
+        if(!_playbackPending) return;
+        _playbackPending = false;
+        std::uint32_t rowCount;
+        snapshot = _player.frame(_playbackFrame, rowCount);
+        if(rowCount != _boundPoses.size()) return;
+        changed = _boundPoses.gather(snapshot);
+    } else if(isSharedPosesAttached()) {
+        std::uint32_t rowCount;
+        const SharedPoseReader::Result result = _sharedPoses.acquire(snapshot, rowCount);
+        if(result == SharedPoseReader::Result::Busy) ++_sharedPoseStats.busy;
+        if(result != SharedPoseReader::Result::Frame) return;
+        if(rowCount != _boundPoses.size()) {
+            _sharedPoses.validate();
+            ++_sharedPoseStats.mismatched;
+            return;
+        }
+        changed = _boundPoses.gather(snapshot);
+        if(!_sharedPoses.validate()) {
+            _boundPoses.discardChanges();
+            ++_sharedPoseStats.torn;
+            return;
+        }
+        ++_sharedPoseStats.frames;
+        /* The writer may be in the slot again by the time it's recorded */
+        snapshot = nullptr;
+    } else if(isPoseReceiverRunning()) {
+        if(!_poseReceiver.update(_boundPoses.size())) return;
+        snapshot = _poseReceiver.snapshot().data();
+        changed = _boundPoses.gather(snapshot);
+    } else if(isSimulationThreadRunning()) {
+        if(!_poseSnapshots.update()) return;
+        snapshot = _poseSnapshots.readBuffer().data();
+        changed = _boundPoses.gather(snapshot);
+    } else changed = _boundPoses.gather();
+    if(!changed) return;
+    if(isRecording()) recordPoses(snapshot);
+
+    _boundTransformations.resize(_boundPoses.size());
+    _boundPoses.computeMatrices(_boundTransformations.front().data());
+    for(std::size_t row: _boundPoses.changedRows()) {
+        _boundObjects[row]->setTransformation(_boundTransformations[row]);
+        _transforms.setLocal(_boundObjects[row]->getId() - 1, _boundTransformations[row].data());
     }
+    appendTrailSamples();
+    requestRedraw();
+}
 
-    for(auto &p: _objectReferencedRot)
-    {
-        Magnum::Math::Matrix4<float>  ct = p.first->transformationMatrix();
-        ct.right() = Vector3(p.second[0],p.second[1],p.second[2]);
-        ct.up() = Vector3(p.second[3],p.second[4],p.second[5]);
-        ct.backward() = Vector3(p.second[6],p.second[7],p.second[8]);
-        p.first->setTransformation(ct);
+static_assert(PoseLog::FloatsPerRow == PoseTable::SnapshotStride, "pose log rows have to be snapshots");
+
+void magnumVisualizer::recordPoses(const float* snapshot) {
+    /* Otherwise taken from what was just gathered */
+    if(!snapshot) {
+        _recordBuffer.resize(_boundPoses.size()*PoseTable::SnapshotStride);
+        _boundPoses.gathered(_recordBuffer.data());
+        snapshot = _recordBuffer.data();
     }
-    redraw();
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - _recordingStart).count();
+    _recorder.write(time, snapshot, std::uint32_t(_boundPoses.size()));
+}
+
+bool magnumVisualizer::startPlayback(const std::string& path) {
+    if(!_player.open(path) || !_player.frameCount()) {
+        _player.close();
+        return false;
+    }
+    _playbackTick = std::chrono::steady_clock::now();
+    seekPlayback(0);
+    return true;
+}
+
+void magnumVisualizer::seekPlayback(std::size_t frame) {
+    if(!isPlayingBack()) return;
+    _playbackFrame = std::min(frame, _player.frameCount() - 1);
+    _playbackTime = _player.time(_playbackFrame);
+    _playbackPending = true;
+}
+
+void magnumVisualizer::advancePlayback() {
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - _playbackTick).count();
+    _playbackTick = now;
+
+    if(m_stepOneFrame) {
+        m_stepOneFrame = false;
+        if(_playbackSpeed >= 0.0) seekPlayback(_playbackFrame + 1);
+        else if(_playbackFrame) seekPlayback(_playbackFrame - 1);
+    } else if(!m_pause) {
+        _playbackTime = Math::clamp(_playbackTime + elapsed*_playbackSpeed, 0.0, _player.duration());
+        const std::size_t frame = _player.frameAt(_playbackTime);
+        if(frame != _playbackFrame) {
+            _playbackFrame = frame;
+            _playbackPending = true;
+        }
+    }
+}
+
+bool magnumVisualizer::addTrail(ObjectHandle handle, const Color3& color) {
+    PickableObject* object = _objects.get(handle);
+    if(!object || object->boundRow() == -1 || object->trail() != -1) return false;
+
+    const UnsignedInt slot = _trails.add(color, object->getId());
+    if(slot >= _trailObjects.size()) _trailObjects.resize(slot + 1);
+    _trailObjects[slot] = object;
+    object->setTrail(slot);
+    return true;
+}
+
+bool magnumVisualizer::removeTrail(ObjectHandle handle) {
+    PickableObject* object = _objects.get(handle);
+    if(!object || object->trail() == -1) return false;
+
+    _trails.remove(object->trail());
+    _trailObjects[object->trail()] = nullptr;
+    object->setTrail(-1);
+    requestRedraw();
+    return true;
+}
+
+void magnumVisualizer::appendTrailSamples() {
+    if(!_trails.size()) return;
+
+    /* Bound poses are relative to the parent, so the samples are taken
+       from the world transformations */
+    updateWorldTransforms();
+    for(std::size_t slot = 0; slot != _trailObjects.size(); ++slot) {
+        const PickableObject* o = _trailObjects[slot];
+        if(!o) continue;
+        const float* world = _transforms.world(o->getId() - 1);
+        _trails.setSample(slot, {world[12], world[13], world[14]});
+    }
+    _trails.append();
+}
+
+int magnumVisualizer::addVectorField(std::size_t count, const float* origins, std::ptrdiff_t originStride, const float* vectors, std::ptrdiff_t vectorStride, Float scale, const Color3& color) {
+    _vectorFields.emplace_back(new VectorField{count, origins, originStride, vectors, vectorStride});
+    _vectorFields.back()->setScale(scale).setColor(color);
+    requestRedraw();
+    return int(_vectorFields.size() - 1);
 }
 
-magnumVisualizer::magnumVisualizer(const Arguments& arguments):
+bool magnumVisualizer::removeVectorField(int field) {
+    if(!vectorField(field)) return false;
+    _vectorFields[field].reset();
+    requestRedraw();
+    return true;
+}
+
+void magnumVisualizer::updateVectorFields() {
+    if(_vectorFields.empty()) return;
+    bool changed = false;
+    if(isSimulationThreadRunning()) {
+        if(!_vectorFieldSnapshots.update()) return;
+        const std::vector<float>& snapshot = _vectorFieldSnapshots.readBuffer();
+        if(snapshot.size() != vectorFieldArrowCount()*VectorField::FloatsPerArrow) return;
+        const float* arrows = snapshot.data();
+        for(const auto& field: _vectorFields) if(field) {
+            changed |= field->update(arrows);
+            arrows += field->size()*VectorField::FloatsPerArrow;
+        }
+    } else for(const auto& field: _vectorFields)
+        if(field) changed |= field->update();
+    if(changed) requestRedraw();
+}
+
+void magnumVisualizer::drawVectorFields() {
+    const Matrix4 cameraMatrix = _camera->cameraMatrix();
+    _arrowMesh.setCount(VectorField::VertexCount);
+    for(const auto& field: _vectorFields) {
+        if(!field || !field->size()) continue;
+        field->bindBuffer();
+        _arrowMesh.setInstanceCount(Int(field->size()));
+        _arrowShader
+            .setTransformationMatrix(cameraMatrix)
+            .setStyle(*field);
+        _arrowMesh.draw(_arrowShader);
+    }
+}
+
+void magnumVisualizer::drawTrails() {
+    if(!_trails.size()) return;
+
+    _trails.bind();
+    _trailMesh.setCount(_trails.vertexCount());
+    _trailShader
+        .setTransformationMatrix(_camera->cameraMatrix())
+        .setRing(_trails);
+    _trailMesh.draw(_trailShader);
+}
+
+magnumVisualizer::magnumVisualizer(const Arguments& arguments, const Vector2i& size):
     _cameraPosX(0.0f), _cameraPosY(0.0f), _cameraPosZ(8.0f),
     m_pause(false), m_stepOneFrame(false), timeStateUpdates(true),
-    _avgStateUpdateTime(0),
-    Platform::Application{arguments, Configuration{}.setTitle("Magnum object picking example")}, _framebuffer{GL::defaultFramebuffer.viewport()} {
+    _selectedPrimative(-1),
+    _instancedRendering(false), _frustumCulling(true), _visibleObjectCount(0), _visibleObjectTotal(0),
+    _drawSorting(true), _stateChangeCount(0),
+    _levelOfDetail(true), _lodThresholds{40.0f, 10.0f}, _lodHysteresis(0.2f), _lodObjectCounts{},
+    _redrawRequested(false), _framesDrawn(0), _framesSkipped(0),
+    _regionDrag(false), _pickResultReady(false), _rayPicking(false), _dragView(-1),
+    _simulationRunning(false), _simulationRate(0.0),
+    _timestepRate(0.0), _timestepAccumulator(0.0), _maxStepsPerTick(100), _stepsLastTick(0),
+    _fasterThanRealTime(false), _lastStepTick(std::chrono::steady_clock::now()),
+    _realTimeWindowStart(_lastStepTick), _realTimeWindowSimulated(0.0), _realTimeFactor(0.0),
+    _playbackFrame(0), _playbackPending(false), _playbackTime(0.0), _playbackSpeed(1.0),
+    VisualizerApplication{arguments, Configuration{}.setTitle("Magnum object picking example").setSize(size)}, _framebuffer{{{}, framebufferSize()}}, _idFramebuffer{{{}, framebufferSize()}}, _lazyIdPass(false) {
     MAGNUM_ASSERT_GL_VERSION_SUPPORTED(GL::Version::GL430);
 
     /* Global renderer configuration */
     GL::Renderer::enable(GL::Renderer::Feature::DepthTest);
 
-    /* Configure framebuffer (using R8UI for object ID which means 255 objects max) */
-    _color.setStorage(GL::RenderbufferFormat::RGBA8, GL::defaultFramebuffer.viewport().size());
-    _objectId.setStorage(GL::RenderbufferFormat::R8UI, GL::defaultFramebuffer.viewport().size());
-    _depth.setStorage(GL::RenderbufferFormat::DepthComponent24, GL::defaultFramebuffer.viewport().size());
+    /* Configure framebuffer (using R32UI for object ID, 0 means no object) */
+    _color.setStorage(GL::RenderbufferFormat::RGBA8, framebufferSize());
+    _objectId.setStorage(GL::RenderbufferFormat::R32UI, framebufferSize());
+    _depth.setStorage(GL::RenderbufferFormat::DepthComponent24, framebufferSize());
     _framebuffer.attachRenderbuffer(GL::Framebuffer::ColorAttachment{0}, _color)
                .attachRenderbuffer(GL::Framebuffer::ColorAttachment{1}, _objectId)
                .attachRenderbuffer(GL::Framebuffer::BufferAttachment::Depth, _depth)
                .mapForDraw({{PhongIdShader::ColorOutput, GL::Framebuffer::ColorAttachment{0}},
                             {PhongIdShader::ObjectIdOutput, GL::Framebuffer::ColorAttachment{1}}});
     CORRADE_INTERNAL_ASSERT(_framebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
+    _idFramebuffer.attachRenderbuffer(GL::Framebuffer::ColorAttachment{1}, _objectId)
+               .attachRenderbuffer(GL::Framebuffer::BufferAttachment::Depth, _depth)
+               .mapForDraw({{PhongIdShader::ColorOutput, GL::Framebuffer::DrawAttachment::None},
+                            {PhongIdShader::ObjectIdOutput, GL::Framebuffer::ColorAttachment{1}}});
+    CORRADE_INTERNAL_ASSERT(_idFramebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
 
     /* Set up meshes */
     //_cube = MeshTools::compile(Primitives::cubeSolid());
-    _cube = MeshTools::compile(Primitives::axis3D());
-    _sphere = MeshTools::compile(Primitives::uvSphereSolid(16, 32));
-    _plane = MeshTools::compile(Primitives::planeSolid());
-    _cylinder = MeshTools::compile(Primitives::cylinderSolid(3, 20, 0.4,  Magnum::Primitives::CylinderFlags{Magnum::Primitives::CylinderFlag::CapEnds}));
+    addPrimitive(_cube, Primitives::axis3D());
+    addPrimitive(_sphere, Primitives::uvSphereSolid(16, 32));
+    addLod(_sphere, Primitives::uvSphereSolid(8, 16));
+    addLod(_sphere, Primitives::uvSphereSolid(4, 8));
+    addPrimitive(_plane, Primitives::planeSolid());
+    addPrimitive(_cylinder, Primitives::cylinderSolid(3, 20, 0.4,  Magnum::Primitives::CylinderFlags{Magnum::Primitives::CylinderFlag::CapEnds}));
+    addLod(_cylinder, Primitives::cylinderSolid(1, 10, 0.4,  Magnum::Primitives::CylinderFlags{Magnum::Primitives::CylinderFlag::CapEnds}));
+    addLod(_cylinder, Primitives::cylinderSolid(1, 5, 0.4,  Magnum::Primitives::CylinderFlags{Magnum::Primitives::CylinderFlag::CapEnds}));
 
     /* Set up objects */
     // _objects.push_back(new PickableObject{1, &_phongShader, 0x3bd267_rgbf, _cylinder, _scene, _drawables});
@@ -432,30 +1684,700 @@ magnumVisualizer::magnumVisualizer(const Arguments& arguments):
     _camera = new SceneGraph::Camera3D{*_cameraObject};
     _camera->setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::Extend)
         .setProjectionMatrix(Matrix4::perspectiveProjection(35.0_degf, 4.0f/3.0f, 0.001f, 100.0f))
-        .setViewport(GL::defaultFramebuffer.viewport().size());
+        .setViewport(framebufferSize());
+    _views.push_back({_cameraObject, _camera, {{}, framebufferSize()}});
+
+    /* Frames are drawn only on change, so without this the tick loop would
+       spin at full rate while idle */
+    setMinimalLoopPeriod(16);
 }
 
-void magnumVisualizer::drawEvent() {
+void magnumVisualizer::addPrimitive(GL::Mesh& mesh, Trade::MeshData3D&& data) {
+    mesh = MeshTools::compile(data);
+
+    /* Bounding sphere around the center of the bounding box */
+    const std::vector<Vector3>& positions = data.positions(0);
+    Vector3 min{positions.front()}, max{positions.front()};
+    for(const Vector3& p: positions) {
+        min = Math::min(min, p);
+        max = Math::max(max, p);
+    }
+    const Vector3 center = (min + max)*0.5f;
+    Float radius = 0.0f;
+    for(const Vector3& p: positions)
+        radius = Math::max(radius, (p - center).length());
+    _meshBounds.emplace(&mesh, std::make_pair(center, radius));
+
+    _meshData.emplace(&mesh, std::move(data));
+}
+
+GL::Mesh* magnumVisualizer::loadMesh(const std::string& path) {
+    auto known = _userMeshPaths.find(path);
+    if(known != _userMeshPaths.end()) return known->second;
+
+    std::unique_ptr<MeshFile> file{new MeshFile};
+    if(!file->load(path, _meshCacheDirectory)) return nullptr;
+    const MeshCache::Header& header = file->header();
+    GL::Mesh*& mesh = _userMeshHashes[header.contentHash];
+    if(!mesh) {
+        /* Straight from the mapping, nothing is touched on the CPU */
+        _userMeshes.emplace_back();
+        mesh = &_userMeshes.back();
+        MeshBuffers& buffers = _userMeshBuffers[mesh];
+        buffers.vertices.setData({file->vertexData(), file->vertexDataSize()}, GL::BufferUsage::StaticDraw);
+        buffers.indices.setData({file->indexData(), file->indexDataSize()}, GL::BufferUsage::StaticDraw);
+        buffers.indexCount = header.indexCount;
+        attachMeshBuffers(*mesh, buffers);
+        _meshBounds.emplace(mesh, std::make_pair(Vector3::from(header.boundsCenter), header.boundsRadius));
+        buffers.file = std::move(file);
+    }
+    _userMeshPaths.emplace(path, mesh);
+    return mesh;
+}
+
+void magnumVisualizer::attachMeshBuffers(GL::Mesh& mesh, MeshBuffers& buffers) {
+    mesh.setPrimitive(GL::MeshPrimitive::Triangles)
+        .setCount(buffers.indexCount)
+        .addVertexBuffer(buffers.vertices, 0, PhongIdShader::Position{}, PhongIdShader::Normal{})
+        .setIndexBuffer(buffers.indices, 0, GL::MeshIndexType::UnsignedInt);
+}
+
+void magnumVisualizer::addLod(GL::Mesh& mesh, Trade::MeshData3D&& data) {
+    auto triangleCount = [](const Trade::MeshData3D& d) {
+        return UnsignedInt((d.isIndexed() ? d.indices().size() : d.positions(0).size())/3);
+    };
+
+    MeshLodChain& lods = _meshLods[&mesh];
+    if(!lods.levelCount) {
+        lods.meshes[0] = &mesh;
+        lods.triangleCounts[0] = triangleCount(_meshData.at(&mesh));
+        lods.levelCount = 1;
+    }
+    CORRADE_INTERNAL_ASSERT(lods.levelCount < MeshLodChain::MaxLevels);
+
+    _lodMeshes.push_back(MeshTools::compile(data));
+    lods.meshes[lods.levelCount] = &_lodMeshes.back();
+    lods.triangleCounts[lods.levelCount] = triangleCount(data);
+    ++lods.levelCount;
+    _meshData.emplace(&_lodMeshes.back(), std::move(data));
+}
+
+void magnumVisualizer::selectLods() {
+    /* Pixels per unit of camera-space size at unit distance */
+    const Float scale = _camera->projectionMatrix()[1][1]*0.5f*Float(_camera->viewport().y());
+    const Matrix4 cameraMatrix = _camera->cameraMatrix();
+    for(UnsignedInt i: _objects.live()) {
+        PickableObject& o = *_objects[i];
+        if(!o.lodChain() || !_objectVisible[i]) continue;
+
+        if(_levelOfDetail) {
+            Vector3 center;
+            Float radius;
+            o.worldBoundingSphere(Matrix4::from(_transforms.world(i)), center, radius);
+            const Float distance = Math::max(-cameraMatrix.transformPoint(center).z(), 1.0e-3f);
+            o.updateLod(radius*scale/distance, _lodThresholds, _lodHysteresis);
+        } else o.resetLod();
+
+        ++_lodObjectCounts[o.lod()];
+    }
+}
+
+void magnumVisualizer::registerObject(ObjectHandle handle, int boundRow) {
+    PickableObject* object = _objects.get(handle);
+    addToInstanceBatch(object);
+
+    auto lods = _meshLods.find(&object->mesh());
+    if(lods != _meshLods.end()) object->setLodChain(&lods->second);
+
+    const std::pair<Vector3, Float>& bounds = _meshBounds.at(&object->mesh());
+    object->setLocalBounds(bounds.first, bounds.second);
+    if(_cullProxies.size() < _objects.slotCount()) {
+        _cullProxies.resize(_objects.slotCount(), -1);
+        _objectVisible.resize(_objects.slotCount(), 0);
+    }
+    _objectVisible[handle.index] = 1;
+    /* The culling proxy is inserted once the world transformation is
+       computed */
+    _transforms.add(handle.index);
+    transformationChanged(handle.index);
+
+    /* Rows are bound in the order objects are registered */
+    if(boundRow != -1) {
+        object->setBoundRow(boundRow);
+        _boundObjects.push_back(object);
+    }
+}
+
+bool magnumVisualizer::remove(ObjectHandle handle) {
+    PickableObject* object = _objects.get(handle);
+    if(!object) return false;
+
+    /* The last bound row moves into the hole */
+    const int row = object->boundRow();
+    if(row != -1) {
+        if(boundRowsFixed()) return false;
+        const std::size_t moved = _boundPoses.remove(row);
+        _boundObjects[row] = _boundObjects[moved];
+        _boundObjects[row]->setBoundRow(row);
+        _boundObjects.pop_back();
+    }
+
+    /* The scene graph would delete the children along with the object */
+    for(Object3D* child = object->children().first(); child; ) {
+        Object3D* next = child->nextSibling();
+        child->setParentKeepTransformation(&_scene);
+        /* Cameras of attached views aren't in the hierarchy */
+        if(std::none_of(_views.begin(), _views.end(), [child](const View& v) { return v.cameraObject == child; })) {
+            const std::size_t index = static_cast<PickableObject*>(child)->getId() - 1;
+            _transforms.setParent(index, TransformHierarchy::NoParent);
+            transformationChanged(index);
+        }
+        child = next;
+    }
+    _transforms.remove(handle.index);
+
+    if(object->trail() != -1) removeTrail(handle);
+    removeFromInstanceBatch(object);
+    if(_cullProxies[handle.index] != -1) _cullTree.remove(_cullProxies[handle.index]);
+    _cullProxies[handle.index] = -1;
+    _objectVisible[handle.index] = 0;
+    if(_selectedPrimative == int(handle.index)) _selectedPrimative = -1;
+
+    _objects.destroy(handle);
+    requestRedraw();
+    return true;
+}
+
+void magnumVisualizer::select(const std::vector<ObjectHandle>& objects) {
+    for(UnsignedInt i: _objects.live()) _objects[i]->setSelected(false);
+    _selectedPrimative = -1;
+    for(ObjectHandle handle: objects) {
+        PickableObject* o = _objects.get(handle);
+        if(!o) continue;
+        o->setSelected(true);
+        if(_selectedPrimative == -1) _selectedPrimative = handle.index;
+    }
+    requestRedraw();
+}
+
+bool magnumVisualizer::setParent(ObjectHandle handle, ObjectHandle parent) {
+    PickableObject* object = _objects.get(handle);
+    PickableObject* parentObject = _objects.get(parent);
+    if(!object || (parent && !parentObject)) return false;
+    if(!_transforms.setParent(handle.index, parent ? int(parent.index) : TransformHierarchy::NoParent))
+        return false;
+    /* Kept in sync so absoluteTransformationMatrix() stays meaningful */
+    object->setParent(parentObject ? static_cast<Object3D*>(parentObject) : &_scene);
+    requestRedraw();
+    return true;
+}
+
+void magnumVisualizer::transformationChanged(std::size_t index) {
+    _transforms.setLocal(index, _objects[index]->transformationMatrix().data());
+}
+
+void magnumVisualizer::updateWorldTransforms() {
+    _transforms.update(&_threadPool);
+    for(std::size_t index: _transforms.updated()) updateCullBounds(index);
+}
+
+void magnumVisualizer::updateCullBounds(std::size_t index) {
+    Vector3 center;
+    Float radius;
+    _objects[index]->worldBoundingSphere(Matrix4::from(_transforms.world(index)), center, radius);
+    const DynamicAabbTree::Aabb box{
+        {center.x() - radius, center.y() - radius, center.z() - radius},
+        {center.x() + radius, center.y() + radius, center.z() + radius}};
+
+    /* Generous margin so objects moving a bit stay in their tree node */
+    const Float margin = 0.5f*radius;
+    if(_cullProxies[index] == -1)
+        _cullProxies[index] = _cullTree.insert(box, int(index), margin);
+    else _cullTree.move(_cullProxies[index], box, margin);
+}
+
+void magnumVisualizer::cull() {
+    if(!_frustumCulling) {
+        std::fill(_objectVisible.begin(), _objectVisible.end(), 1);
+        _visibleObjectCount = _objects.size();
+        return;
+    }
+
+    std::fill(_objectVisible.begin(), _objectVisible.end(), 0);
+    _visibleObjectCount = 0;
+
+    /* Frustum planes in world space */
+    const Frustum frustum = Frustum::fromMatrix(_camera->projectionMatrix()*_camera->cameraMatrix());
+    const Vector4 frustumPlanes[]{frustum.left(), frustum.right(), frustum.bottom(),
+                                  frustum.top(), frustum.near(), frustum.far()};
+    float planes[6][4];
+    for(std::size_t i = 0; i != 6; ++i)
+        for(std::size_t j = 0; j != 4; ++j) planes[i][j] = frustumPlanes[i][j];
+
+    _cullTree.queryPlanes(planes, [this](int index) {
+        _objectVisible[index] = 1;
+        ++_visibleObjectCount;
+    });
+}
+
+void magnumVisualizer::addToInstanceBatch(PickableObject* object) {
+    const std::pair<GL::Mesh*, pickableShaders> key{&object->mesh(), object->shaderType()};
+    auto found = _instanceBatches.find(key);
+    if(found == _instanceBatches.end()) {
+        /* The batch lives in the map from now on, so the mesh can reference
+           its instance buffer */
+        InstanceBatch& batch = _instanceBatches[key];
+        batch.shaderType = key.second;
+        auto lods = _meshLods.find(key.first);
+        batch.levelCount = lods != _meshLods.end() ? lods->second.levelCount : 1;
+        for(std::size_t i = 0; i != batch.levelCount; ++i) {
+            GL::Mesh* source = lods != _meshLods.end() ? lods->second.meshes[i] : key.first;
+            InstanceBatch::Level& level = batch.levels[i];
+            auto userMesh = _userMeshBuffers.find(source);
+            if(userMesh != _userMeshBuffers.end()) {
+                level.mesh = GL::Mesh{};
+                attachMeshBuffers(level.mesh, userMesh->second);
+            } else level.mesh = MeshTools::compile(_meshData.at(source));
+            level.mesh.addVertexBufferInstanced(level.instanceBuffer, 1, 0,
+                PhongIdInstancedShader::TransformationMatrix{},
+                PhongIdInstancedShader::InstanceColor{},
+                PhongIdInstancedShader::ObjectId{},
+                PhongIdInstancedShader::Selected{});
+        }
+        found = _instanceBatches.find(key);
+    }
+    object->setBatchIndex(found->second.objects.size());
+    found->second.objects.push_back(object);
+}
+
+void magnumVisualizer::removeFromInstanceBatch(PickableObject* object) {
+    std::vector<PickableObject*>& objects = _instanceBatches.at({&object->mesh(), object->shaderType()}).objects;
+    const std::size_t index = object->batchIndex();
+    objects[index] = objects.back();
+    objects[index]->setBatchIndex(index);
+    objects.pop_back();
+}
+
+void magnumVisualizer::drawInstanced() {
+    const Matrix4 cameraMatrix = _camera->cameraMatrix();
+    for(auto& b: _instanceBatches) {
+        InstanceBatch& batch = b.second;
+        if(batch.objects.empty()) continue;
+
+        for(std::size_t i = 0; i != batch.levelCount; ++i)
+            batch.levels[i].instanceData.clear();
+        for(PickableObject* o: batch.objects) {
+            if(!_objectVisible[o->getId() - 1]) continue;
+            batch.levels[o->lod()].instanceData.push_back(o->instanceData(cameraMatrix*Matrix4::from(_transforms.world(o->getId() - 1))));
+        }
+
+        for(std::size_t i = 0; i != batch.levelCount; ++i) {
+            InstanceBatch::Level& level = batch.levels[i];
+            if(level.instanceData.empty()) continue;
+            level.instanceBuffer.setData(Containers::arrayView(level.instanceData.data(), level.instanceData.size()), GL::BufferUsage::DynamicDraw);
+            level.mesh.setInstanceCount(level.instanceData.size());
+            if(batch.shaderType == phongShader) level.mesh.draw(_phongInstancedShader);
+            else level.mesh.draw(_vertexInstancedShader);
+        }
+    }
+}
+
+GL::AbstractFramebuffer& magnumVisualizer::renderTarget(RenderTarget target) {
+    switch(target) {
+        case RenderTarget::Window: return GL::defaultFramebuffer;
+        case RenderTarget::Framebuffer: return _framebuffer;
+        case RenderTarget::IdFramebuffer: return _idFramebuffer;
+    }
+    CORRADE_ASSERT_UNREACHABLE();
+}
+
+void magnumVisualizer::clearTarget(RenderTarget target) {
+    switch(target) {
+        /* Only color, the default framebuffer has no attachment for the ID
+           output so it's discarded */
+        case RenderTarget::Window:
+            GL::defaultFramebuffer
+                .clearColor(Color3{0.125f})
+                .clearDepth(1.0f);
+            return;
+        case RenderTarget::Framebuffer:
+            _framebuffer
+                .clearColor(0, Color3{0.125f})
+                .clearColor(1, Vector4ui{})
+                .clearDepth(1.0f);
+            return;
+        case RenderTarget::IdFramebuffer:
+            _idFramebuffer
+                .clearColor(1, Vector4ui{})
+                .clearDepth(1.0f);
+            return;
+    }
+}
+
+Range2Di magnumVisualizer::framebufferRange(const Range2Di& windowRange) const {
+    const Int height = framebufferSize().y();
+    return {{windowRange.min().x(), height - windowRange.max().y()},
+            {windowRange.max().x(), height - windowRange.min().y()}};
+}
+
+void magnumVisualizer::drawScene() {
     /* Draw to custom framebuffer */
-    _framebuffer
-        .clearColor(0, Color3{0.125f})
-        .clearColor(1, Vector4ui{})
-        .clearDepth(1.0f)
-        .bind();
-    _camera->draw(_drawables);
-
-    /* Bind the main buffer back */
-    GL::defaultFramebuffer.clear(GL::FramebufferClear::Color|GL::FramebufferClear::Depth)
-        .bind();
-
-    /* Blit color to window framebuffer */
-    _framebuffer.mapForRead(GL::Framebuffer::ColorAttachment{0});
-    GL::AbstractFramebuffer::blit(_framebuffer, GL::defaultFramebuffer,
-        {{}, _framebuffer.viewport().size()}, GL::FramebufferBlit::Color);
+    RenderTarget target = RenderTarget::Framebuffer;
+    #ifndef MAGNUM_VISUALIZER_HEADLESS
+    if(_lazyIdPass) target = RenderTarget::Window;
+    #endif
+    clearTarget(target);
+    renderTarget(target).bind();
+
+    {
+        FrameTimings::Scope t{_frameTimings, FrameTimings::WorldTransforms, timeStateUpdates};
+        updateWorldTransforms();
+    }
+    FrameTimings::Scope t{_frameTimings, FrameTimings::Draw, timeStateUpdates};
+    /* Summed over the views of this frame */
+    std::fill(std::begin(_lodObjectCounts), std::end(_lodObjectCounts), 0);
+    _visibleObjectTotal = 0;
+    _stateChangeCount = 0;
+    renderScene(target, {{}, framebufferSize()});
+}
+
+void magnumVisualizer::drawIdPass(const Range2Di& range) {
+    updateWorldTransforms();
+    /* Clearing respects the scissor too */
+    GL::Renderer::enable(GL::Renderer::Feature::ScissorTest);
+    GL::Renderer::setScissor(range);
+    clearTarget(RenderTarget::IdFramebuffer);
+    _idFramebuffer.bind();
+
+    /* The stats stay those of the last drawn frame */
+    std::size_t lodObjectCounts[MeshLodChain::MaxLevels];
+    std::copy(std::begin(_lodObjectCounts), std::end(_lodObjectCounts), lodObjectCounts);
+    const std::size_t visibleObjectTotal = _visibleObjectTotal;
+    const std::size_t stateChangeCount = _stateChangeCount;
+    renderScene(RenderTarget::IdFramebuffer, range);
+    std::copy(std::begin(lodObjectCounts), std::end(lodObjectCounts), _lodObjectCounts);
+    _visibleObjectTotal = visibleObjectTotal;
+    _stateChangeCount = stateChangeCount;
+}
+
+void magnumVisualizer::renderScene(RenderTarget target, const Range2Di& range) {
+    /* Every view is scissored to its rectangle, which is cleared first if
+       an earlier view was drawn there */
+    GL::AbstractFramebuffer& framebuffer = renderTarget(target);
+    GL::Renderer::enable(GL::Renderer::Feature::ScissorTest);
+    bool first = true;
+    for(const View& view: _views) {
+        if(!view.camera) continue;
+        const Range2Di viewport = framebufferRange(view.viewport);
+        const Range2Di scissor = Math::intersect(viewport, range);
+        if(scissor.sizeX() <= 0 || scissor.sizeY() <= 0) continue;
+        GL::Renderer::setScissor(scissor);
+        if(!first) clearTarget(target);
+        first = false;
+        framebuffer.setViewport(viewport);
+        _camera = view.camera;
+
+        cull();
+        selectLods();
+        _visibleObjectTotal += _visibleObjectCount;
+
+        /* Constants of all shaders, uploaded once per view */
+        const FrameUniforms frame{_camera->projectionMatrix(),
+            /* relative to the camera */
+            {13.0f, 2.0f, 5.0f, 0.0f}};
+        _frameUniforms.setData(Containers::arrayView(&frame, 1), GL::BufferUsage::DynamicDraw);
+        _frameUniforms.bind(GL::Buffer::Target::Uniform, FrameUniforms::Binding);
+
+        if(_instancedRendering) drawInstanced();
+        else drawObjects();
+        drawTrails();
+        drawVectorFields();
+    }
+    framebuffer.setViewport({{}, framebufferSize()});
+    GL::Renderer::disable(GL::Renderer::Feature::ScissorTest);
+}
+
+void magnumVisualizer::drawObjects() {
+    /* Write the data of all visible objects in one pass, only they get their
+       transformation computed. Then draw setting nothing but the index into
+       the buffer. */
+    _drawList.clear();
+    _renderQueue.clear();
+    ObjectData* const data = _objectData.map(_visibleObjectCount);
+    const UnsignedInt offset = _objectData.offset();
+    const Matrix4 cameraMatrix = _camera->cameraMatrix();
+    for(UnsignedInt i: _objects.live()) {
+        if(!_objectVisible[i]) continue;
+        PickableObject& o = *_objects[i];
+        const UnsignedInt n = UnsignedInt(_drawList.size());
+        const Matrix4 transformationMatrix = cameraMatrix*Matrix4::from(_transforms.world(i));
+        data[n] = o.objectData(transformationMatrix);
+        o.setDrawIndex(offset + n);
+        _drawList.push_back(&o);
+        /* Mesh IDs past 16 bits would only split a group, not misorder */
+        _renderQueue.push(RenderQueue::key(o.shaderType(), UnsignedShort(o.currentMesh().id()),
+            -transformationMatrix.translation().z()), n);
+    }
+    _objectData.unmap(_drawList.size());
+
+    if(_drawSorting) _renderQueue.sort();
+
+    _objectData.bind(ObjectData::Binding);
+    int shader = -1;
+    GL::Mesh* mesh = nullptr;
+    for(const RenderQueue::Item& item: _renderQueue.items()) {
+        PickableObject& o = *_drawList[item.index];
+        if(o.shaderType() != shader) {
+            shader = o.shaderType();
+            ++_stateChangeCount;
+        }
+        if(&o.currentMesh() != mesh) {
+            mesh = &o.currentMesh();
+            ++_stateChangeCount;
+        }
+        o.submit();
+    }
+    _objectData.fence();
+}
+
+void magnumVisualizer::drawEvent() {
+    _redrawRequested = false;
+    ++_framesDrawn;
+
+    drawScene();
 
+    #ifndef MAGNUM_VISUALIZER_HEADLESS
+    if(_lazyIdPass) {
+        if(_capture.isOpen())
+            _capture.capture(GL::defaultFramebuffer, _framebuffer.viewport());
+    } else
+    #endif
+    {
+        _framebuffer.mapForRead(GL::Framebuffer::ColorAttachment{0});
+        if(_capture.isOpen())
+            _capture.capture(_framebuffer, _framebuffer.viewport());
+    }
+
+    #ifndef MAGNUM_VISUALIZER_HEADLESS
+    if(!_lazyIdPass) {
+        FrameTimings::Scope t{_frameTimings, FrameTimings::Blit, timeStateUpdates};
+
+        /* Bind the main buffer back */
+        GL::defaultFramebuffer.clear(GL::FramebufferClear::Color|GL::FramebufferClear::Depth)
+            .bind();
+
+        /* Blit color to window framebuffer */
+        GL::AbstractFramebuffer::blit(_framebuffer, GL::defaultFramebuffer,
+            {{}, _framebuffer.viewport().size()}, GL::FramebufferBlit::Color);
+    }
+    #endif
+
+    FrameTimings::Scope t{_frameTimings, FrameTimings::Swap, timeStateUpdates};
     swapBuffers();
 }
 
+#ifdef MAGNUM_VISUALIZER_HEADLESS
+int magnumVisualizer::exec() {
+    while(!_exitRequested && (!_frameLimit || _framesDrawn < _frameLimit)) {
+        tickEvent();
+        drawEvent();
+    }
+    stopSimulationThread();
+    stopCapture();
+    return _exitCode;
+}
+#endif
+
+void magnumVisualizer::pickRegion(const Range2Di& rectangle, PickCallback callback) {
+    /* Framebuffer has Y up while windowing system Y down. The ID buffer
+       has each view in its rectangle, so the IDs come from the view that
+       was clicked. */
+    const Range2Di range = Math::intersect(framebufferRange(rectangle), _framebuffer.viewport());
+    if(range.size().x() <= 0 || range.size().y() <= 0) return;
+
+    /* Queue the read into a pixel buffer, the data are fetched only after
+       the fence signals in resolvePicks(). Without the ID output in drawn
+       frames, render just the picked region first. */
+    _pendingPicks.emplace_back();
+    PendingPick& p = _pendingPicks.back();
+    #ifndef MAGNUM_VISUALIZER_HEADLESS
+    if(_lazyIdPass) {
+        drawIdPass(range);
+        _idFramebuffer.mapForRead(GL::Framebuffer::ColorAttachment{1});
+        _idFramebuffer.read(range, p.image, GL::BufferUsage::StreamRead);
+    } else
+    #endif
+    {
+        _framebuffer.mapForRead(GL::Framebuffer::ColorAttachment{1});
+        _framebuffer.read(range, p.image, GL::BufferUsage::StreamRead);
+    }
+    p.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    p.callback = std::move(callback);
+}
+
+bool magnumVisualizer::castRay(const Vector3& origin, const Vector3& direction, RayHit& hit) {
+    updateWorldTransforms();
+    const Vector3 d = direction.normalized();
+    const float o[3]{origin.x(), origin.y(), origin.z()};
+    const float dir[3]{d.x(), d.y(), d.z()};
+    Float closest = Constants::inf();
+    int closestIndex = -1;
+    _cullTree.queryRay(o, dir, closest, [&](int index, float entry) {
+        Float distance;
+        if(entry <= closest && intersectObject(index, origin, d, closest, distance)) {
+            closest = distance;
+            closestIndex = index;
+        }
+        return closest;
+    });
+    if(closestIndex == -1) return false;
+
+    hit = {_objects.handle(closestIndex), closest, origin + d*closest};
+    return true;
+}
+
+bool magnumVisualizer::pickRay(const Vector2i& position, RayHit& hit) {
+    const int index = viewAt(position);
+    if(index == -1) return false;
+    const View& view = _views[index];
+
+    /* Through the pixel center, window Y goes down */
+    const Vector2 offset{position - view.viewport.min()};
+    const Vector2 viewport{view.viewport.size()};
+    const Vector2 ndc{2.0f*(offset.x() + 0.5f)/viewport.x() - 1.0f,
+                      1.0f - 2.0f*(offset.y() + 0.5f)/viewport.y()};
+    const Matrix4 unproject = (view.camera->projectionMatrix()*view.camera->cameraMatrix()).inverted();
+    const Vector4 near = unproject*Vector4{ndc, -1.0f, 1.0f};
+    const Vector4 far = unproject*Vector4{ndc, 1.0f, 1.0f};
+    const Vector3 origin = near.xyz()/near.w();
+    return castRay(origin, far.xyz()/far.w() - origin, hit);
+}
+
+int magnumVisualizer::addView(const Range2Di& viewport, const Matrix4& cameraTransformation, Deg fieldOfView) {
+    View view;
+    view.cameraObject = new Object3D{&_scene};
+    view.cameraObject->setTransformation(cameraTransformation);
+    view.camera = new SceneGraph::Camera3D{*view.cameraObject};
+    view.camera->setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::Extend)
+        .setProjectionMatrix(Matrix4::perspectiveProjection(fieldOfView, 4.0f/3.0f, 0.001f, 100.0f));
+    _views.push_back(view);
+    /* Every view maps its own region of the object data each frame */
+    _objectData.setMapsPerFrame(viewCount());
+    setViewport(int(_views.size() - 1), viewport);
+    return int(_views.size() - 1);
+}
+
+bool magnumVisualizer::removeView(int view) {
+    if(view == 0 || !viewCamera(view)) return false;
+    /* Deletes the camera with it */
+    delete _views[view].cameraObject;
+    _views[view] = {};
+    _objectData.setMapsPerFrame(viewCount());
+    if(_dragView == view) _dragView = -1;
+    requestRedraw();
+    return true;
+}
+
+bool magnumVisualizer::setViewport(int view, const Range2Di& viewport) {
+    if(!viewCamera(view)) return false;
+    _views[view].viewport = viewport;
+    _views[view].camera->setViewport(viewport.size());
+    requestRedraw();
+    return true;
+}
+
+bool magnumVisualizer::attachView(int view, ObjectHandle object) {
+    PickableObject* parent = _objects.get(object);
+    if(!viewCamera(view) || (object && !parent)) return false;
+    _views[view].cameraObject->setParentKeepTransformation(parent ? static_cast<Object3D*>(parent) : &_scene);
+    requestRedraw();
+    return true;
+}
+
+int magnumVisualizer::viewAt(const Vector2i& position) const {
+    for(std::size_t i = _views.size(); i != 0; --i) {
+        const View& view = _views[i - 1];
+        if(view.camera && view.viewport.contains(position)) return int(i - 1);
+    }
+    return -1;
+}
+
+const TriangleBvh& magnumVisualizer::meshBvh(GL::Mesh& mesh) {
+    auto found = _meshBvhs.find(&mesh);
+    if(found != _meshBvhs.end()) return found->second;
+
+    TriangleBvh& bvh = _meshBvhs[&mesh];
+    auto userMesh = _userMeshBuffers.find(&mesh);
+    if(userMesh != _userMeshBuffers.end()) {
+        const MeshFile& file = *userMesh->second.file;
+        bvh.build(file.vertexData(), sizeof(MeshCache::Vertex),
+            reinterpret_cast<const std::uint32_t*>(file.indexData()), file.header().indexCount/3);
+    } else {
+        const Trade::MeshData3D& data = _meshData.at(&mesh);
+        if(data.primitive() == MeshPrimitive::Triangles && data.isIndexed())
+            bvh.build(data.positions(0).data(), sizeof(Vector3), data.indices().data(), data.indices().size()/3);
+    }
+    return bvh;
+}
+
+bool magnumVisualizer::intersectObject(UnsignedInt index, const Vector3& origin, const Vector3& direction, Float maxDistance, Float& distance) {
+    PickableObject& o = *_objects[index];
+    const Matrix4& world = Matrix4::from(_transforms.world(index));
+    const TriangleBvh& bvh = meshBvh(o.mesh());
+
+    if(!bvh.triangleCount()) {
+        Vector3 center;
+        Float radius;
+        o.worldBoundingSphere(world, center, radius);
+        const Vector3 toCenter = center - origin;
+        const Float along = Math::dot(toCenter, direction);
+        const Float inside = radius*radius - (toCenter.dot() - along*along);
+        if(inside < 0.0f || along + std::sqrt(inside) < 0.0f) return false;
+        /* Zero if the ray starts inside the sphere */
+        distance = Math::max(along - std::sqrt(inside), 0.0f);
+        return distance <= maxDistance;
+    }
+
+    /* Not renormalized, so the ray parameter is the same in object space
+       even if the object is scaled */
+    const Matrix4 inverse = world.inverted();
+    const Vector3 localOrigin = inverse.transformPoint(origin);
+    const Vector3 localDirection = inverse.transformVector(direction);
+    const float o3[3]{localOrigin.x(), localOrigin.y(), localOrigin.z()};
+    const float d3[3]{localDirection.x(), localDirection.y(), localDirection.z()};
+    return bvh.raycast(o3, d3, maxDistance, distance);
+}
+
+void magnumVisualizer::resolvePicks() {
+    while(!_pendingPicks.empty()) {
+        PendingPick& p = _pendingPicks.front();
+        const GLenum status = glClientWaitSync(p.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+        glDeleteSync(p.fence);
+
+        const Containers::Array<char> data = p.image.buffer().data();
+        const UnsignedInt* ids = reinterpret_cast<const UnsignedInt*>(data.data());
+        const std::size_t count = std::size_t(p.image.size().product());
+        /* IDs of objects removed since are skipped, the pool doesn't reuse
+           their slots right away */
+        std::vector<ObjectHandle> objects;
+        for(std::size_t i = 0; i != count; ++i) {
+            if(!ids[i]) continue;
+            const ObjectHandle handle = _objects.handle(ids[i] - 1);
+            if(handle) objects.push_back(handle);
+        }
+        std::sort(objects.begin(), objects.end());
+        objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+
+        _pickResult = objects;
+        _pickResultReady = true;
+        PickCallback callback = std::move(p.callback);
+        _pendingPicks.pop_front();
+        if(callback) callback(objects);
+    }
+}
+
+#ifndef MAGNUM_VISUALIZER_HEADLESS
 // void magnumVisualizer::mouseScrollEvent(mouseScrollEvent& event) {
 //     if(event.button() == MouseEvent::Button::WheelUp){
 //         _cameraPosZ += 0.1f;
@@ -471,46 +2393,53 @@ void magnumVisualizer::mousePressEvent(MouseEvent& event) {
     if(event.button() != MouseEvent::Button::Left) return;
 
     _previousMousePosition = _mousePressPosition = event.position();
+    _regionDrag = bool(event.modifiers() & MouseEvent::Modifier::Shift);
+    _dragView = viewAt(event.position());
     event.setAccepted();
 }
 
 void magnumVisualizer::mouseMoveEvent(MouseMoveEvent& event) {
-    if(!(event.buttons() & MouseMoveEvent::Button::Left)) return;
+    /* The view may have been removed since the drag started */
+    if(!(event.buttons() & MouseMoveEvent::Button::Left) || _regionDrag || !viewCameraObject(_dragView)) return;
 
     const Vector2 delta = 3.0f*
         Vector2{event.position() - _previousMousePosition}/
         Vector2{GL::defaultFramebuffer.viewport().size()};
 
-    (*_cameraObject)
-        .rotate(Rad{-delta.y()}, _cameraObject->transformation().right().normalized())
+    /* The camera of the view the drag started in */
+    Object3D& cameraObject = *_views[_dragView].cameraObject;
+    cameraObject
+        .rotate(Rad{-delta.y()}, cameraObject.transformation().right().normalized())
         .rotateY(Rad{-delta.x()});
 
     _previousMousePosition = event.position();
     event.setAccepted();
-    redraw();
+    requestRedraw();
 }
 
 void magnumVisualizer::mouseReleaseEvent(MouseEvent& event) {
-    if(event.button() != MouseEvent::Button::Left || _mousePressPosition != event.position()) return;
+    if(event.button() != MouseEvent::Button::Left) return;
 
-    /* Read object ID at given click position (framebuffer has Y up while windowing system Y down) */
-    _framebuffer.mapForRead(GL::Framebuffer::ColorAttachment{1});
-    Image2D data = _framebuffer.read(
-        Range2Di::fromSize({event.position().x(), _framebuffer.viewport().sizeY() - event.position().y() - 1}, {1, 1}),
-        {PixelFormat::R8UI});
+    /* Highlight the objects under mouse or in the dragged box and deselect
+       all other once the readback is done */
+    auto select = [this](const std::vector<ObjectHandle>& objects) {
+        // only select if any ID is valid
+        if(objects.empty()) return;
+        this->select(objects);
+    };
 
-    // only select if ID is valid
-    if(data.data<UnsignedByte>()[0] > 0){
-        /* Highlight object under mouse and deselect all other */
-        for(auto* o: _objects) o->setSelected(false);
-        UnsignedByte id = data.data<UnsignedByte>()[0];
-        _selectedPrimative = int(id) - 1;
-        if(id > 0 && id < _objects.size()+1)
-        _objects[id - 1]->setSelected(true);
-    }
+    if(_regionDrag) {
+        const Vector2i min = Math::min(_mousePressPosition, event.position());
+        const Vector2i max = Math::max(_mousePressPosition, event.position());
+        pickRegion({min, max + Vector2i{1}}, select);
+        _regionDrag = false;
+    } else if(_mousePressPosition == event.position()) {
+        RayHit hit;
+        if(!_rayPicking) pick(event.position(), select);
+        else if(pickRay(event.position(), hit)) this->select({hit.object});
+    } else return;
 
     event.setAccepted();
-    redraw();
 }
 
 void magnumVisualizer::keyPressEvent(KeyEvent& event) {
@@ -538,6 +2467,7 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::Enter:
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::Esc:
+            stopSimulationThread();
             exit();
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::Up:
@@ -552,28 +2482,32 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
             if(_selectedPrimative>=0){
                 Math::Rad<float> a(0.1);
                 _objects[_selectedPrimative]->rotateLocal(a, Vector3(1,0,0));
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::End:
             if(_selectedPrimative>=0){
                 Math::Rad<float> a(0.1);
                 _objects[_selectedPrimative]->rotateLocal(a, Vector3(-1,0,0));
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::PageUp:
             if(_selectedPrimative>=0){
                 Math::Rad<float> a(0.1);
                 _objects[_selectedPrimative]->rotateLocal(a, Vector3(0,0,-1));
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::PageDown:
             if(_selectedPrimative>=0){
                 Math::Rad<float> a(0.1);
                 _objects[_selectedPrimative]->rotateLocal(a, Vector3(0,-1,0));
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::Backspace:
@@ -582,14 +2516,16 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
         if(_selectedPrimative>=0){
             Math::Rad<float> a(0.1);
             _objects[_selectedPrimative]->rotateLocal(a, Vector3(0,0,1));
-            redraw();
+            transformationChanged(_selectedPrimative);
+            requestRedraw();
         }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::Delete:
           if(_selectedPrimative>=0){
               Math::Rad<float> a(0.1);
               _objects[_selectedPrimative]->rotateLocal(a, Vector3(0,1,0));
-              redraw();
+              transformationChanged(_selectedPrimative);
+              requestRedraw();
           }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::F1:
@@ -661,8 +2597,10 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
             updateCameraLocation();
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::B:
+            setLazyIdPass(!_lazyIdPass);
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::C:
+            setFrustumCulling(!_frustumCulling);
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::D:
             _cameraPosX -= 0.1f;
@@ -679,12 +2617,15 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::H:
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::I:
+            setInstancedRendering(!_instancedRendering);
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::J:
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::K:
+            setRayPicking(!_rayPicking);
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::L:
+            setLevelOfDetail(!_levelOfDetail);
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::M:
             break;
@@ -701,12 +2642,19 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
             updateCameraLocation();
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::R:
+            setDrawSorting(!_drawSorting);
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::S:
             _cameraPosZ -= 0.1f;
             updateCameraLocation();
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::T:
+            _frameTimings.writeSummary(std::cout);
+            {
+                const ShaderCache::Stats& cache = ShaderCache::global().stats();
+                std::cout << "shader cache: " << cache.hits << " hits, " << cache.misses
+                    << " misses, " << cache.savedNanoseconds*1e-6 << " ms saved\n";
+            }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::U:
             break;
@@ -730,7 +2678,8 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
             // _primPos[_selectable2primIdx[_selectedPrimative]][1] -= 0.1f;
             if(_selectedPrimative>=0){
                 _objects[_selectedPrimative]->translate({0.0, -0.1, 0.0});
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumThree:
@@ -738,7 +2687,8 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumFour:
             if(_selectedPrimative>=0){
                 _objects[_selectedPrimative]->translate({-0.1, 0.0, 0.0});
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumFive:
@@ -746,25 +2696,29 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumSix:
             if(_selectedPrimative>=0){
                 _objects[_selectedPrimative]->translate({0.1, 0.0, 0.0});
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumSeven:
             if(_selectedPrimative>=0){
                 _objects[_selectedPrimative]->translate({0.0, 0.0, -0.1});
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumEight:
             if(_selectedPrimative>=0){
                 _objects[_selectedPrimative]->translate({0.0, 0.1, 0.0});
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
                 }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumNine:
             if(_selectedPrimative>=0){
                 _objects[_selectedPrimative]->translate({0.0, 0.0, 0.1});
-                redraw();
+                transformationChanged(_selectedPrimative);
+                requestRedraw();
             }
             break;
         case Magnum::Platform::Sdl2Application::KeyEvent::Key::NumDecimal:
@@ -785,6 +2739,7 @@ void magnumVisualizer::keyPressEvent(KeyEvent& event) {
             break;
       }
   }
+#endif
 
 }
 
@@ -0,0 +1,13 @@
+in mediump vec3 transformedNormal;
+in highp vec3 lightDirection;
+flat in lowp vec3 arrowColor;
+
+layout(location = 0) out lowp vec4 fragmentColor;
+layout(location = 1) out highp uint fragmentObjectId;
+
+void main() {
+    /* Arrows aren't objects, nothing to pick */
+    lowp float intensity = max(0.0, dot(normalize(transformedNormal), normalize(lightDirection)));
+    fragmentColor = vec4(arrowColor*(0.25 + 0.75*intensity), 1.0);
+    fragmentObjectId = 0u;
+}
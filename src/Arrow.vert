@@ -0,0 +1,95 @@
+/* Transformation from world space to camera space */
+uniform highp mat4 transformationMatrix;
+/* Arrow length per vector length and shaft radius, see VectorField */
+uniform highp float scale;
+uniform highp float radius;
+uniform lowp vec3 color;
+/* Vector lengths mapped from blue to red, off if y <= x */
+uniform highp vec2 colorRange;
+
+/* Origin and vector of arrow i are arrows[6*i] to arrows[6*i + 5], packed
+   to 24 bytes as a vec3 array would be padded to 16 */
+layout(std430, binding = 4) readonly buffer Arrows {
+    highp float arrows[];
+};
+
+/* Matches VectorField::Sides */
+const highp uint Sides = 8u;
+
+out mediump vec3 transformedNormal;
+out highp vec3 lightDirection;
+flat out lowp vec3 arrowColor;
+
+void main() {
+    highp uint base = 6u*uint(gl_InstanceID);
+    highp vec3 origin = vec3(arrows[base], arrows[base + 1u], arrows[base + 2u]);
+    highp vec3 vector = vec3(arrows[base + 3u], arrows[base + 4u], arrows[base + 5u]);
+    highp float magnitude = length(vector);
+    highp float arrowLength = magnitude*scale;
+
+    /* Zero vectors get all vertices outside of the clip volume */
+    if(arrowLength <= 0.0) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        transformedNormal = vec3(0.0);
+        lightDirection = vec3(0.0);
+        arrowColor = vec3(0.0);
+        return;
+    }
+
+    /* Head twice as wide as the shaft and at most half the arrow long */
+    highp float headRadius = 2.0*radius;
+    highp float headLength = min(3.0*headRadius, 0.5*arrowLength);
+    highp float shaftEnd = arrowLength - headLength;
+
+    /* The arrow is 6 vertices per side for the shaft, then 3 per side for
+       the head cone and 3 per side for the disk closing the head, see
+       VectorField::VertexCount. Position and normal are in the arrow frame
+       with z along the vector. */
+    highp uint v = uint(gl_VertexID);
+    highp uint side, corner;
+    highp vec3 position, normal;
+    if(v < 6u*Sides) {
+        side = v/6u;
+        corner = v % 6u;
+        /* Two triangles, (0, 0) (1, 0) (1, 1) and (0, 0) (1, 1) (0, 1) in
+           (next side, far end) */
+        highp uint next = corner == 1u || corner == 2u || corner == 4u ? 1u : 0u;
+        highp uint far = corner == 2u || corner == 4u || corner == 5u ? 1u : 0u;
+        highp float angle = 6.2831853*float(side + next)/float(Sides);
+        normal = vec3(cos(angle), sin(angle), 0.0);
+        position = vec3(radius*normal.xy, far == 1u ? shaftEnd : 0.0);
+    } else if(v < 9u*Sides) {
+        side = (v - 6u*Sides)/3u;
+        corner = (v - 6u*Sides) % 3u;
+        /* The tip normal is the one of the middle of the side */
+        highp float angle = 6.2831853*(float(side) + (corner == 2u ? 0.5 : float(corner)))/float(Sides);
+        normal = normalize(vec3(cos(angle), sin(angle), headRadius/headLength));
+        position = corner == 2u ? vec3(0.0, 0.0, arrowLength) :
+            vec3(headRadius*cos(angle), headRadius*sin(angle), shaftEnd);
+    } else {
+        side = (v - 9u*Sides)/3u;
+        corner = (v - 9u*Sides) % 3u;
+        highp float angle = 6.2831853*float(side + (corner == 1u ? 1u : 0u))/float(Sides);
+        normal = vec3(0.0, 0.0, -1.0);
+        position = corner == 2u ? vec3(0.0, 0.0, shaftEnd) :
+            vec3(headRadius*cos(angle), headRadius*sin(angle), shaftEnd);
+    }
+
+    /* Frame around the vector, any perpendicular axes do */
+    highp vec3 axis = vector/magnitude;
+    highp vec3 x = normalize(cross(abs(axis.z) < 0.9 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0), axis));
+    highp vec3 y = cross(axis, x);
+    highp vec3 worldPosition = origin + position.x*x + position.y*y + position.z*axis;
+
+    highp vec4 transformedPosition4 = transformationMatrix*vec4(worldPosition, 1.0);
+    transformedNormal = mat3(transformationMatrix)*(normal.x*x + normal.y*y + normal.z*axis);
+    lightDirection = normalize(light.xyz - transformedPosition4.xyz);
+
+    if(colorRange.y > colorRange.x) {
+        highp float t = clamp((magnitude - colorRange.x)/(colorRange.y - colorRange.x), 0.0, 1.0);
+        /* Blue, cyan, green, yellow, red */
+        arrowColor = clamp(vec3(1.5) - abs(4.0*t - vec3(3.0, 2.0, 1.0)), 0.0, 1.0);
+    } else arrowColor = color;
+
+    gl_Position = projectionMatrix*transformedPosition4;
+}
@@ -27,16 +27,16 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-uniform lowp vec3 ambientColor;
-uniform lowp vec3 color;
-uniform lowp uint objectId;
+flat in lowp vec3 ambientColor;
+flat in lowp vec3 color;
+flat in highp uint objectId;
 
 in mediump vec3 transformedNormal;
 in highp vec3 lightDirection;
 in highp vec3 cameraDirection;
 
 layout(location = 0) out lowp vec4 fragmentColor;
-layout(location = 1) out lowp uint fragmentObjectId;
+layout(location = 1) out highp uint fragmentObjectId;
 
 void main() {
     mediump vec3 normalizedTransformedNormal = normalize(transformedNormal);
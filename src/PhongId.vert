@@ -27,10 +27,7 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-uniform highp mat4 transformationMatrix;
-uniform highp mat4 projectionMatrix;
-uniform mediump mat3 normalMatrix;
-uniform highp vec3 light;
+uniform highp uint objectIndex;
 
 /* Matches PhongIdShader::Position and PhongIdShader::Normal definitions */
 layout(location = 0) in highp vec4 position;
@@ -39,21 +36,33 @@ layout(location = 2) in mediump vec3 normal;
 out mediump vec3 transformedNormal;
 out highp vec3 lightDirection;
 out highp vec3 cameraDirection;
+flat out lowp vec3 ambientColor;
+flat out lowp vec3 color;
+flat out highp uint objectId;
 
 void main() {
+    ObjectData object = objects[objectIndex];
+
     /* Transformed vertex position */
-    highp vec4 transformedPosition4 = transformationMatrix*position;
+    highp vec4 transformedPosition4 = object.transformationMatrix*position;
     highp vec3 transformedPosition = transformedPosition4.xyz/transformedPosition4.w;
 
-    /* Transformed normal vector */
-    transformedNormal = normalMatrix*normal;
+    /* Transformed normal vector, with the rotation-scaling part of the
+       transformation */
+    transformedNormal = mat3(object.transformationMatrix)*normal;
 
     /* Direction to the light */
-    lightDirection = normalize(light - transformedPosition);
+    lightDirection = normalize(light.xyz - transformedPosition);
 
     /* Direction to the camera */
     cameraDirection = -transformedPosition;
 
+    /* Selection highlight */
+    bool selected = object.selected > 0.5;
+    ambientColor = selected ? object.color*0.3 : vec3(0.0);
+    color = object.color*(selected ? 2.0 : 1.0);
+    objectId = object.objectId;
+
     /* Transform the position */
     gl_Position = projectionMatrix*transformedPosition4;
 }
@@ -0,0 +1,40 @@
+layout(location = POSITION_ATTRIBUTE_LOCATION) in highp vec4 position;
+layout(location = NORMAL_ATTRIBUTE_LOCATION) in mediump vec3 normal;
+
+/* Per-instance data, matches PhongIdInstancedShader attribute definitions */
+layout(location = TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION) in highp mat4 instanceTransformationMatrix;
+layout(location = INSTANCE_COLOR_ATTRIBUTE_LOCATION) in lowp vec3 instanceColor;
+layout(location = OBJECT_ID_ATTRIBUTE_LOCATION) in highp uint instanceObjectId;
+layout(location = SELECTED_ATTRIBUTE_LOCATION) in lowp float instanceSelected;
+
+out mediump vec3 transformedNormal;
+out highp vec3 lightDirection;
+out highp vec3 cameraDirection;
+flat out lowp vec3 ambientColor;
+flat out lowp vec3 color;
+flat out highp uint objectId;
+
+void main() {
+    /* Transformed vertex position */
+    highp vec4 transformedPosition4 = instanceTransformationMatrix*position;
+    highp vec3 transformedPosition = transformedPosition4.xyz/transformedPosition4.w;
+
+    /* Transformed normal vector, with the rotation-scaling part of the
+       transformation */
+    transformedNormal = mat3(instanceTransformationMatrix)*normal;
+
+    /* Direction to the light */
+    lightDirection = normalize(light.xyz - transformedPosition);
+
+    /* Direction to the camera */
+    cameraDirection = -transformedPosition;
+
+    /* Selection highlight, same as in PhongId.vert */
+    bool selected = instanceSelected > 0.5;
+    ambientColor = selected ? instanceColor*0.3 : vec3(0.0);
+    color = instanceColor*(selected ? 2.0 : 1.0);
+    objectId = instanceObjectId;
+
+    /* Transform the position */
+    gl_Position = projectionMatrix*transformedPosition4;
+}
@@ -0,0 +1,10 @@
+in lowp vec3 interpolatedColor;
+flat in highp uint objectId;
+
+layout(location = 0) out lowp vec4 fragmentColor;
+layout(location = 1) out highp uint fragmentObjectId;
+
+void main() {
+    fragmentColor = vec4(interpolatedColor, 1.0);
+    fragmentObjectId = objectId;
+}
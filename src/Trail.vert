@@ -0,0 +1,53 @@
+/* Transformation from world space to camera space */
+uniform highp mat4 transformationMatrix;
+/* Samples appended so far, samples kept per trail and row stride of the
+   ring, see TrailBuffer */
+uniform highp uint sampleCount;
+uniform highp uint trailLength;
+uniform highp uint trailStride;
+
+/* Sample k of trail t is at samples[(k % trailLength)*trailStride + t] */
+layout(std430, binding = 2) readonly buffer TrailSamples {
+    highp vec4 samples[];
+};
+
+/* Matches TrailData in TrailBuffer.h */
+struct TrailData {
+    lowp vec3 color;
+    highp uint firstSample;
+    highp uint objectId;
+};
+
+layout(std430, binding = 3) readonly buffer Trails {
+    TrailData trails[];
+};
+
+out lowp vec3 interpolatedColor;
+flat out highp uint objectId;
+
+void main() {
+    /* Two vertices per segment, trailLength - 1 segments per trail, the
+       newest segment first */
+    highp uint segments = trailLength - 1u;
+    highp uint trail = uint(gl_VertexID)/(2u*segments);
+    highp uint segment = uint(gl_VertexID)/2u % segments;
+    highp uint age = segment + uint(gl_VertexID) % 2u;
+    TrailData data = trails[trail];
+    objectId = data.objectId;
+
+    /* If the older end of the segment wasn't recorded (for this trail),
+       both vertices go to the same point outside of the clip volume and the
+       whole segment gets clipped */
+    if(segment + 2u > sampleCount || sampleCount - 2u - segment < data.firstSample) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        interpolatedColor = vec3(0.0);
+        return;
+    }
+
+    highp uint index = sampleCount - 1u - age;
+    highp vec4 position = vec4(samples[(index % trailLength)*trailStride + trail].xyz, 1.0);
+    gl_Position = projectionMatrix*transformationMatrix*position;
+
+    /* Fade out to the background color with age */
+    interpolatedColor = mix(data.color, vec3(0.125), float(age)/float(trailLength));
+}
@@ -22,8 +22,8 @@
     FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
     DEALINGS IN THE SOFTWARE.
 */
-uniform lowp uint objectId;
-uniform lowp float brightness;
+flat in highp uint objectId;
+flat in lowp float brightness;
 
 #define NEW_GLSL
 // #ifndef NEW_GLSL
@@ -35,11 +35,11 @@ uniform lowp float brightness;
 in lowp vec4 interpolatedColor;
 #ifdef NEW_GLSL
 layout(location = 0) out lowp vec4 fragmentColor;
-layout(location = 1) out lowp uint fragmentObjectId;
+layout(location = 1) out highp uint fragmentObjectId;
 #endif
 
 // layout(location = 0) out lowp vec4 fragmentColor;
-// layout(location = 1) out lowp uint fragmentObjectId;
+// layout(location = 1) out highp uint fragmentObjectId;
 
 
 void main() {
@@ -28,15 +28,7 @@
 #define out varying
 #endif
 
-layout(location = 0)
-// #ifdef EXPLICIT_UNIFORM_LOCATION
-// layout(location = 0)
-// #endif
-uniform mat4 transformationProjectionMatrix
-    #ifndef GL_ES
-    = mat4(1.0)
-    #endif
-    ;
+uniform highp uint objectIndex;
 
 #ifdef EXPLICIT_ATTRIB_LOCATION
 layout(location = POSITION_ATTRIBUTE_LOCATION)
@@ -49,8 +41,13 @@ layout(location = COLOR_ATTRIBUTE_LOCATION)
 in lowp vec4 color;
 
 out lowp vec4 interpolatedColor;
+flat out lowp float brightness;
+flat out highp uint objectId;
 
 void main() {
-    gl_Position = transformationProjectionMatrix*position;
+    ObjectData object = objects[objectIndex];
+    gl_Position = projectionMatrix*object.transformationMatrix*position;
     interpolatedColor = color;
+    brightness = object.selected > 0.5 ? 1.0 : 0.5;
+    objectId = object.objectId;
 }
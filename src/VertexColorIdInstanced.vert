@@ -0,0 +1,18 @@
+layout(location = POSITION_ATTRIBUTE_LOCATION) in highp vec4 position;
+layout(location = COLOR_ATTRIBUTE_LOCATION) in lowp vec4 color;
+
+/* Per-instance data, matches PhongIdInstancedShader attribute definitions.
+   The instance color is unused, the mesh has its own vertex colors. */
+layout(location = TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION) in highp mat4 instanceTransformationMatrix;
+layout(location = OBJECT_ID_ATTRIBUTE_LOCATION) in highp uint instanceObjectId;
+layout(location = SELECTED_ATTRIBUTE_LOCATION) in lowp float instanceSelected;
+
+out lowp vec4 interpolatedColor;
+flat out highp uint objectId;
+
+void main() {
+    gl_Position = projectionMatrix*instanceTransformationMatrix*position;
+    /* Same brightness as in VertexColorId.vert */
+    interpolatedColor = (instanceSelected > 0.5 ? 1.0 : 0.5)*color;
+    objectId = instanceObjectId;
+}
@@ -0,0 +1,20 @@
+/* Per-frame constants shared by all shaders, matches FrameUniforms in
+   magnumVisualizer.h */
+layout(std140, binding = 0) uniform FrameUniforms {
+    highp mat4 projectionMatrix;
+    /* Relative to the camera, w is unused */
+    highp vec4 light;
+};
+
+/* Per-object data of the non-instanced shaders, matches ObjectData in
+   magnumVisualizer.h. Indexed with the objectIndex uniform. */
+struct ObjectData {
+    highp mat4 transformationMatrix;
+    lowp vec3 color;
+    highp uint objectId;
+    lowp float selected;
+};
+
+layout(std430, binding = 1) readonly buffer Objects {
+    ObjectData objects[];
+};
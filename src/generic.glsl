@@ -30,3 +30,12 @@
 #define NORMAL_ATTRIBUTE_LOCATION 2
 #define COLOR_ATTRIBUTE_LOCATION 3
 #define TANGENT_ATTRIBUTE_LOCATION 4
+
+/* Per-instance attributes of the instanced shaders, keep consistent with
+   PhongIdInstancedShader in magnumVisualizer.h. The matrix takes four
+   consecutive locations. */
+
+#define TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION 5
+#define INSTANCE_COLOR_ATTRIBUTE_LOCATION 9
+#define OBJECT_ID_ATTRIBUTE_LOCATION 10
+#define SELECTED_ATTRIBUTE_LOCATION 11
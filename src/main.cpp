@@ -19,15 +19,31 @@ public:
             1.0f, 0.0f, 0.0f});
         add3dAxisGUI();
         add3dAxisGUI(0.0, 0.1);
-        add3dAxisVisualization((float*)&_pos[0], (float*)&_rot[0]);
+        const Magnum::ObjectHandle axis = add3dAxisVisualization((float*)&_pos[0], (float*)&_rot[0]);
+        addTrail(axis);
         addCylinder((float*)&_pos[1], (float*)&_rot[1], 0.01f);
+        /* Velocity of the axis, ten times longer than it moves per second */
+        addVectorField(1, _pos[0].data(), sizeof(_pos[0]), _velocity.data(), sizeof(_velocity), 10.0f);
+        /* Top-down view following the axis in the top right corner */
+        const Magnum::Vector2i size = framebufferSize();
+        const int overview = addView({{size.x()*2/3, 0}, {size.x(), size.y()/3}},
+            Magnum::Matrix4::lookAt({0.0f, 4.0f, 0.0f}, {}, -Magnum::Vector3::zAxis()));
+        attachView(overview, axis);
+
+        /* Step at 1 kHz no matter how fast frames are drawn */
+        setFixedTimestep(1000.0);
     };
     virtual void stateUpdate(){
-        _pos[0][0] += 0.001f;
+        _pos[0][0] += _velocity[0]*float(timestep());
     };
 private:
     std::vector<std::array<float, 3>> _pos;
     std::vector<std::array<float, 9>> _rot;
+    std::array<float, 3> _velocity{{0.06f, 0.0f, 0.0f}};
 };
 
+#ifdef MAGNUM_VISUALIZER_HEADLESS
+MAGNUM_WINDOWLESSAPPLICATION_MAIN(myApp)
+#else
 MAGNUM_APPLICATION_MAIN(myApp)
+#endif